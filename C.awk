@@ -21,7 +21,12 @@
 
 # Generates C header and implementation from decision table CSV pseudocode
 # Usage: awk -f C.awk file.psu
+#        awk -v table=1 -f C.awk file.psu
 # Generates file.h and file.c
+# With table=1 the DAG is a packed node array run by a small loop instead of gotos
+# With batch=1 nameEvaluateN is added, the DAG over arrays of inputs, branchless
+# With lut=bytes the outputs of every input are looked up by a key packed from
+# the inputs, when the lookup table fits in bytes, the DAG otherwise
 
 BEGIN {
   # Extract name from filename or use "stdin"
@@ -148,17 +153,31 @@ function to_c_ident(s,    result, i, c) {
 }
 
 # Store body lines for two-pass processing
-/^[LJTR],/ {
+/^[LJTRSC],/ {
   body[++num_body] = $0
 }
 
 END {
-  if (num_body > 0) {
+  if (num_body > 0 && lut) {
+    build_table()
+    if (!(lut_ok = build_lut()))
+      print "C.awk: lookup table over " lut " bytes, DAG output" > "/dev/stderr"
+  }
+  if (num_body > 0 && lut_ok) {
+    emit_header()
+    emit_lut_body()
+  } else if (num_body > 0 && table) {
+    build_table()
+    emit_header()
+    emit_table_body()
+  } else if (num_body > 0) {
+    if (batch)
+      build_table()
     # First pass: collect jump targets
     for (i = 1; i <= num_body; i++) {
       line = body[i]
-      if (line ~ /^T,/) {
-        # Test: T,var,val,label
+      if (line ~ /^[TC],/) {
+        # Test or case: T,var,val,label
         parse_csv(line, f)
         label = f[4]
         jump_target[label] = 1
@@ -175,6 +194,13 @@ END {
     # Second pass: emit code, filtering unused labels
     for (i = 1; i <= num_body; i++) {
       line = body[i]
+      # The case lines of a switch end at the first other line
+      if (in_switch && line !~ /^C,/) {
+        print "  default:" > cfile
+        print "    break;" > cfile
+        print "  }" > cfile
+        in_switch = 0
+      }
       if (line ~ /^L,/) {
         # Label: L,n
         parse_csv(line, f)
@@ -191,6 +217,18 @@ END {
         c_val = to_c_ident(val)
         print "  if (" c_var " == " name "_" c_var "_" c_val ")" > cfile
         print "    goto L" label ";" > cfile
+      } else if (line ~ /^S,/) {
+        # Switch: S,var then its C lines, no match falls through
+        parse_csv(line, f)
+        print "  switch (" to_c_ident(f[2]) ") {" > cfile
+        in_switch = 1
+      } else if (line ~ /^C,/) {
+        # Case: C,var,val,label
+        parse_csv(line, f)
+        c_var = to_c_ident(f[2])
+        c_val = to_c_ident(f[3])
+        print "  case " name "_" c_var "_" c_val ":" > cfile
+        print "    goto L" f[4] ";" > cfile
       } else if (line ~ /^J,/) {
         # Jump: J,label
         parse_csv(line, f)
@@ -305,11 +343,19 @@ function emit_header(    i, j, k, var, val, vals, n, c_var, c_val) {
 
   print ");" > hfile
 
+  if (table)
+    emit_table_decl()
+
   # === C FILE ===
   # Include header
   print "#include \"" name ".h\"" > cfile
   print "" > cfile
 
+  if (lut_ok)
+    emit_lut_data()
+  else if (table)
+    emit_table_data()
+
   # Function definition
   print "void" > cfile
   print func_name "(" > cfile
@@ -336,6 +382,9 @@ function emit_header(    i, j, k, var, val, vals, n, c_var, c_val) {
 }
 
 function emit_footer() {
+  if (batch)
+    emit_batch_decl()
+
   # Close header guard
   print "" > hfile
   print "#endif" > hfile
@@ -344,4 +393,481 @@ function emit_footer() {
   print "L0:" > cfile
   print "  return;" > cfile
   print "}" > cfile
+
+  if (batch)
+    emit_batch()
+}
+
+# === TABLE MODE ===
+# A test node is (input, value, true next, false next); a resolve node is
+# (NAME_IN, first entry in the side array, entries, next). S lines are
+# skipped, their C lines are tests. Node numbers follow the body order.
+
+# Node reached from body line i: labels are skipped and jumps followed
+function table_target(i,    g) {
+  for (g = 0; g <= num_body; g++) {
+    if (i > num_body)
+      return num_nodes
+    if (body[i] ~ /^[LS],/) {
+      if (body[i] ~ /^L,0$/)
+        return num_nodes
+      i++
+    } else if (body[i] ~ /^J,/) {
+      parse_csv(body[i], f)
+      if (f[2] == "0")
+        return num_nodes
+      i = label_line[f[2]]
+    } else
+      return node_at[i]
+  }
+  # a jump loop, not from dtc
+  return num_nodes
+}
+
+# value_rank[var, val] is the enum value of val, in the sorted order of emit_header
+function rank_values(var, vals_of, n,    j, k, v, vals) {
+  for (j = 1; j <= n; j++)
+    vals[j] = vals_of[var, j]
+  for (j = 1; j < n; j++)
+    for (k = j + 1; k <= n; k++)
+      if (vals[j] > vals[k]) {
+        v = vals[j]
+        vals[j] = vals[k]
+        vals[k] = v
+      }
+  for (j = 1; j <= n; j++)
+    value_rank[var, vals[j]] = j - 1
+}
+
+function build_table(    i, j, n, width) {
+  num_nodes = 0
+  num_res = 0
+  for (i = 1; i <= num_inputs; i++) {
+    input_index[input_vars[i]] = i - 1
+    rank_values(input_vars[i], input_vals, input_val_count[input_vars[i]])
+  }
+  for (i = 1; i <= num_outputs; i++) {
+    output_index[output_vars[i]] = i - 1
+    rank_values(output_vars[i], output_vals, output_val_count[output_vars[i]])
+  }
+  # First pass: number the nodes and the resolve entries
+  for (i = 1; i <= num_body; i++) {
+    line = body[i]
+    if (line ~ /^L,/) {
+      parse_csv(line, f)
+      label_line[f[2]] = i
+    } else if (line ~ /^[TC],/) {
+      node_at[i] = num_nodes++
+    } else if (line ~ /^R,/) {
+      if (i == 1 || body[i - 1] !~ /^R,/) {
+        node_at[i] = num_nodes++
+        res_first[i] = num_res
+      }
+      parse_csv(line, f)
+      res_out[num_res] = output_index[f[2]]
+      res_vi[num_res] = value_rank[f[2], f[3]]
+      res_val[num_res++] = name "_" to_c_ident(f[2]) "_" to_c_ident(f[3])
+    }
+  }
+  # Second pass: the fields of the nodes
+  for (i = 1; i <= num_body; i++) {
+    if (!(i in node_at))
+      continue
+    n = node_at[i]
+    parse_csv(body[i], f)
+    if (body[i] ~ /^[TC],/) {
+      node_i[n] = input_index[f[2]]
+      node_var[n] = to_c_ident(f[2])
+      node_vi[n] = value_rank[f[2], f[3]]
+      node_v[n] = name "_" to_c_ident(f[2]) "_" to_c_ident(f[3])
+      node_t[n] = table_target(label_line[f[4]])
+      node_f[n] = table_target(i + 1)
+    } else {
+      for (j = i; j <= num_body && body[j] ~ /^R,/; j++);
+      node_i[n] = name_upper "_IN"
+      node_v[n] = res_first[i]
+      node_t[n] = j - i
+      node_f[n] = table_target(j)
+    }
+  }
+  # The narrowest index type for all the fields
+  width = num_nodes
+  if (num_res > width)
+    width = num_res
+  if (num_inputs > width)
+    width = num_inputs
+  for (i = 1; i <= num_inputs; i++)
+    if (input_val_count[input_vars[i]] > width)
+      width = input_val_count[input_vars[i]]
+  for (i = 1; i <= num_outputs; i++)
+    if (output_val_count[output_vars[i]] > width)
+      width = output_val_count[output_vars[i]]
+  if (width < 256)
+    index_type = "unsigned char"
+  else if (width < 65536)
+    index_type = "unsigned short"
+  else
+    index_type = "unsigned int"
+}
+
+function emit_table_decl() {
+  print "" > hfile
+  print "#define " name_upper "_IN " num_inputs > hfile
+  print "#define " name_upper "_OUT " num_outputs > hfile
+  print "" > hfile
+  print "typedef " index_type " " name "_ix_t;" > hfile
+  print "" > hfile
+  print "/* a table of the same width and enums can replace " name "Tbl in " name "Run */" > hfile
+  print "struct " name "_nod {" > hfile
+  print "  " name "_ix_t i; /* input, or " name_upper "_IN for a resolve list */" > hfile
+  print "  " name "_ix_t v; /* value, or first entry of the list in r */" > hfile
+  print "  " name "_ix_t t; /* next when equal, or entries of the list */" > hfile
+  print "  " name "_ix_t f; /* next otherwise, nn is the end */" > hfile
+  print "};" > hfile
+  print "" > hfile
+  print "struct " name "_res {" > hfile
+  print "  " name "_ix_t o; /* output */" > hfile
+  print "  " name "_ix_t v; /* value */" > hfile
+  print "};" > hfile
+  print "" > hfile
+  print "struct " name "_tbl {" > hfile
+  print "  unsigned int nn;" > hfile
+  print "  const struct " name "_nod *n;" > hfile
+  print "  const struct " name "_res *r;" > hfile
+  print "};" > hfile
+  print "" > hfile
+  print "extern const struct " name "_tbl " name "Tbl;" > hfile
+  print "" > hfile
+  print "/* in and out are indexed in the order of the " func_name " arguments, out is only set when resolved */" > hfile
+  print "void" > hfile
+  print name "Run(" > hfile
+  print "  const struct " name "_tbl *t" > hfile
+  print " ,const int *in" > hfile
+  print " ,int *out" > hfile
+  print ");" > hfile
+}
+
+function emit_table_data(    n) {
+  print "static const struct " name "_nod " name "Nod[] = {" > cfile
+  for (n = 0; n < num_nodes; n++)
+    print (n ? " ," : "  ") "{" node_i[n] ", " node_v[n] ", " node_t[n] ", " node_f[n] "}" > cfile
+  if (!num_nodes)
+    print "  {0, 0, 0, 0}" > cfile
+  print "};" > cfile
+  print "" > cfile
+  print "static const struct " name "_res " name "Res[] = {" > cfile
+  for (n = 0; n < num_res; n++)
+    print (n ? " ," : "  ") "{" res_out[n] ", " res_val[n] "}" > cfile
+  if (!num_res)
+    print "  {0, 0}" > cfile
+  print "};" > cfile
+  print "" > cfile
+  print "const struct " name "_tbl " name "Tbl = {" num_nodes ", " name "Nod, " name "Res};" > cfile
+  print "" > cfile
+  print "void" > cfile
+  print name "Run(" > cfile
+  print "  const struct " name "_tbl *t" > cfile
+  print " ,const int *in" > cfile
+  print " ,int *out" > cfile
+  print "){" > cfile
+  print "  const struct " name "_nod *n;" > cfile
+  print "  unsigned int p;" > cfile
+  print "  unsigned int k;" > cfile
+  print "" > cfile
+  print "  for (p = 0; p < t->nn;) {" > cfile
+  print "    n = t->n + p;" > cfile
+  print "    if (n->i < " name_upper "_IN)" > cfile
+  print "      p = in[n->i] == n->v ? n->t : n->f;" > cfile
+  print "    else {" > cfile
+  print "      for (k = n->v; k < (unsigned int)n->v + n->t; ++k)" > cfile
+  print "        out[(t->r + k)->o] = (t->r + k)->v;" > cfile
+  print "      p = n->f;" > cfile
+  print "    }" > cfile
+  print "  }" > cfile
+  print "}" > cfile
+  print "" > cfile
+}
+
+function emit_table_body(    i, c_var) {
+  print "  int in[" name_upper "_IN];" > cfile
+  if (num_outputs)
+    print "  int out[" name_upper "_OUT];" > cfile
+  print "" > cfile
+  for (i = 1; i <= num_inputs; i++)
+    print "  in[" i - 1 "] = " to_c_ident(input_vars[i]) ";" > cfile
+  for (i = 1; i <= num_outputs; i++)
+    print "  out[" i - 1 "] = *" to_c_ident(output_vars[i]) ";" > cfile
+  print "  " name "Run(&" name "Tbl, in, " (num_outputs ? "out" : "0") ");" > cfile
+  for (i = 1; i <= num_outputs; i++) {
+    c_var = to_c_ident(output_vars[i])
+    print "  *" c_var " = (enum " name "_" c_var "_e)out[" i - 1 "];" > cfile
+  }
+  print "}" > cfile
+
+  if (batch) {
+    emit_batch_decl()
+    emit_batch()
+  }
+
+  print "" > hfile
+  print "#endif" > hfile
+}
+
+# === BATCH ===
+# The table nodes in an order where a node comes after all that lead to it.
+# For each element a node has a mask of "reached", a test passes it on to
+# one of its next nodes and a resolve selects its value by it, so there are
+# no branches and the loop over the elements can be vectorized.
+
+function batch_visit(n) {
+  if (n >= num_nodes || (n in batch_seen))
+    return
+  batch_seen[n] = 1
+  if (node_i[n] != name_upper "_IN")
+    batch_visit(node_t[n])
+  batch_visit(node_f[n])
+  batch_post[++num_post] = n
+}
+
+function batch_params(file,    i, c_var) {
+  print "  unsigned int _n" > file
+  for (i = 1; i <= num_inputs; i++) {
+    c_var = to_c_ident(input_vars[i])
+    print " ,const enum " name "_" c_var "_e *" c_var > file
+  }
+  for (i = 1; i <= num_outputs; i++) {
+    c_var = to_c_ident(output_vars[i])
+    print " ,enum " name "_" c_var "_e *" c_var > file
+  }
+}
+
+function emit_batch_decl() {
+  print "" > hfile
+  print "/* " func_name " of element i of each array for i < _n, outputs are only set when resolved */" > hfile
+  print "void" > hfile
+  print func_name "N(" > hfile
+  batch_params(hfile)
+  print ");" > hfile
+}
+
+function emit_batch(    i, j, k, n, m, c_var) {
+  num_post = 0
+  if (num_nodes)
+    batch_visit(0)
+  print "" > cfile
+  print "void" > cfile
+  print func_name "N(" > cfile
+  batch_params(cfile)
+  print "){" > cfile
+  print "  unsigned int _i;" > cfile
+  print "" > cfile
+  print "  for (_i = 0; _i < _n; ++_i) {" > cfile
+  print "    unsigned int _t;" > cfile
+  for (n = 0; n < num_nodes; n++)
+    if (n in batch_seen)
+      print "    unsigned int _m" n ";" > cfile
+  for (i = 1; i <= num_outputs; i++)
+    print "    unsigned int _o" i - 1 ";" > cfile
+  print "" > cfile
+  for (n = 0; n < num_nodes; n++)
+    if (n in batch_seen)
+      print "    _m" n " = " (n ? "0" : "~0U") ";" > cfile
+  # the loop is in the enum of the output, Evaluate leaves it as it was when unresolved
+  for (i = 1; i <= num_outputs; i++)
+    print "    _o" i - 1 " = (unsigned int)" to_c_ident(output_vars[i]) "[_i];" > cfile
+  for (k = num_post; k >= 1; k--) {
+    n = batch_post[k]
+    m = "_m" n
+    if (node_i[n] != name_upper "_IN") {
+      print "    _t = -(unsigned int)(" node_var[n] "[_i] == " node_v[n] ");" > cfile
+      if (node_t[n] < num_nodes)
+        print "    _m" node_t[n] " |= " m " & _t;" > cfile
+      if (node_f[n] < num_nodes)
+        print "    _m" node_f[n] " |= " m " & ~_t;" > cfile
+    } else {
+      for (j = node_v[n]; j < node_v[n] + node_t[n]; j++)
+        print "    _o" res_out[j] " = (_o" res_out[j] " & ~" m ") | ((unsigned int)" res_val[j] " & " m ");" > cfile
+      if (node_f[n] < num_nodes)
+        print "    _m" node_f[n] " |= " m ";" > cfile
+    }
+  }
+  for (i = 1; i <= num_outputs; i++) {
+    c_var = to_c_ident(output_vars[i])
+    print "    " c_var "[_i] = (enum " name "_" c_var "_e)_o" i - 1 ";" > cfile
+  }
+  print "  }" > cfile
+  print "}" > cfile
+}
+
+# === LOOKUP TABLE ===
+# The key is the inputs in mixed radix, the first the most significant. An
+# entry is the outputs in mixed radix, the first the least significant, with
+# an extra digit for "not resolved" on the outputs that need it. Two levels
+# when the blocks of the last inputs repeat enough to be smaller.
+
+function lut_width(m) {
+  return m < 256 ? 1 : m < 65536 ? 2 : 4
+}
+
+function lut_type(w) {
+  return w == 1 ? "unsigned char" : w == 2 ? "unsigned short" : "unsigned int"
+}
+
+# The entry of key k, by running the table nodes
+function lut_run(k,    i, j, p, x, e, o) {
+  for (i = num_inputs; i >= 1; i--) {
+    x[i - 1] = k % input_val_count[input_vars[i]]
+    k = int(k / input_val_count[input_vars[i]])
+  }
+  for (j = 0; j < num_outputs; j++)
+    o[j] = -1
+  for (p = 0; p < num_nodes;)
+    if (node_i[p] != name_upper "_IN")
+      p = x[node_i[p]] == node_vi[p] ? node_t[p] : node_f[p]
+    else {
+      for (j = node_v[p]; j < node_v[p] + node_t[p]; j++)
+        o[res_out[j]] = res_vi[j]
+      p = node_f[p]
+    }
+  e = 0
+  for (j = num_outputs - 1; j >= 0; j--) {
+    if (o[j] < 0) {
+      lut_unset[j] = 1
+      o[j] = output_val_count[output_vars[j + 1]]
+    }
+    e = e * (output_val_count[output_vars[j + 1]] + 1) + o[j]
+  }
+  return e
+}
+
+function build_lut(    k, j, l, b, m, size, best, cell, ent, key, nb, radix) {
+  lut_keys = 1
+  for (j = 1; j <= num_inputs; j++)
+    if ((lut_keys *= input_val_count[input_vars[j]]) > lut)
+      return 0
+  for (k = 0; k < lut_keys; k++)
+    ent[k] = lut_run(k)
+  # re-encode without the "not resolved" digit of the outputs that never are
+  m = 1
+  for (j = 0; j < num_outputs; j++) {
+    lut_radix[j] = output_val_count[output_vars[j + 1]] + (j in lut_unset)
+    m *= lut_radix[j]
+  }
+  for (k = 0; k < lut_keys; k++) {
+    cell = 0
+    l = 1
+    b = ent[k]
+    for (j = 0; j < num_outputs; j++) {
+      radix = output_val_count[output_vars[j + 1]] + 1
+      cell += (b % radix) * l
+      b = int(b / radix)
+      l *= lut_radix[j]
+    }
+    lut_ent[k] = cell
+  }
+  lut_ew = lut_width(m)
+  # flat, or the smallest two-level split with blocks of the last j inputs
+  best = lut_keys * lut_ew
+  lut_block = 0
+  l = 1
+  for (j = num_inputs; j > 1; j--) {
+    l *= input_val_count[input_vars[j]]
+    for (key in seen)
+      delete seen[key]
+    nb = 0
+    for (b = 0; b < lut_keys / l; b++) {
+      key = ""
+      for (k = b * l; k < (b + 1) * l; k++)
+        key = key "," lut_ent[k]
+      if (!(key in seen))
+        seen[key] = nb++
+    }
+    size = lut_keys / l * lut_width(nb) + nb * l * lut_ew
+    if (size < best) {
+      best = size
+      lut_block = l
+    }
+  }
+  if (best > lut)
+    return 0
+  lut_size = best
+  return 1
+}
+
+function emit_lut_data(    k, b, nb, key, n, line, l1, seen) {
+  print "/* " lut_size " bytes of lookup table for " lut_keys " inputs */" > cfile
+  if (lut_block) {
+    nb = 0
+    for (b = 0; b < lut_keys / lut_block; b++) {
+      key = ""
+      for (k = b * lut_block; k < (b + 1) * lut_block; k++)
+        key = key "," lut_ent[k]
+      if (!(key in seen)) {
+        seen[key] = nb
+        lut_first[nb++] = b * lut_block
+      }
+      l1[b] = seen[key]
+    }
+    print "static const " lut_type(lut_width(nb)) " " name "Lut1[] = {" > cfile
+    lut_emit(l1, lut_keys / lut_block)
+    print "};" > cfile
+    print "" > cfile
+    for (b = 0; b < nb; b++)
+      for (k = 0; k < lut_block; k++)
+        line[b * lut_block + k] = lut_ent[lut_first[b] + k]
+    n = nb * lut_block
+  } else {
+    for (k = 0; k < lut_keys; k++)
+      line[k] = lut_ent[k]
+    n = lut_keys
+  }
+  print "static const " lut_type(lut_ew) " " name "Lut[] = {" > cfile
+  lut_emit(line, n)
+  print "};" > cfile
+  print "" > cfile
+}
+
+# n values of a, 16 to a line
+function lut_emit(a, n,    k, s) {
+  for (k = 0; k < n; k++) {
+    s = s (k % 16 ? "," : k ? "\n ," : "  ") a[k]
+  }
+  print s > cfile
+}
+
+function emit_lut_body(    i, j, c_var) {
+  print "  unsigned int k;" > cfile
+  print "  unsigned int e;" > cfile
+  print "  unsigned int v;" > cfile
+  print "" > cfile
+  print "  /* the inputs must be values of their enums */" > cfile
+  print "  k = " to_c_ident(input_vars[1]) ";" > cfile
+  for (i = 2; i <= num_inputs; i++)
+    print "  k = k * " input_val_count[input_vars[i]] " + " to_c_ident(input_vars[i]) ";" > cfile
+  if (lut_block)
+    print "  e = " name "Lut[" name "Lut1[k / " lut_block "] * " lut_block " + k % " lut_block "];" > cfile
+  else
+    print "  e = " name "Lut[k];" > cfile
+  for (j = 0; j < num_outputs; j++) {
+    c_var = to_c_ident(output_vars[j + 1])
+    if (j + 1 < num_outputs) {
+      print "  v = e % " lut_radix[j] ";" > cfile
+      print "  e /= " lut_radix[j] ";" > cfile
+    } else
+      print "  v = e;" > cfile
+    # a select rather than a branch for the outputs not always resolved
+    if (j in lut_unset)
+      print "  *" c_var " = v != " lut_radix[j] - 1 " ? (enum " name "_" c_var "_e)v : *" c_var ";" > cfile
+    else
+      print "  *" c_var " = (enum " name "_" c_var "_e)v;" > cfile
+  }
+  print "}" > cfile
+
+  if (batch) {
+    emit_batch_decl()
+    emit_batch()
+  }
+
+  print "" > hfile
+  print "#endif" > hfile
 }
@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+"""
+Time dtc over a fixed corpus and compare with a baseline.
+
+Usage: python3 bench.py [--update] dtc baseline
+
+The corpus is the example tables and tables generated by gen.py with fixed
+arguments. For each the compile time, peak RSS and resulting D are printed.
+The first run (or --update) writes them to the baseline file; later runs
+compare with it: a changed D (or a run that no longer finishes) is an error,
+and time or RSS more than 25% over the baseline is flagged.
+"""
+
+import os
+import sys
+import time
+import tempfile
+import subprocess
+
+import gen
+
+# name, dtc flags, example file or gen.py arguments
+CORPUS = [
+    ('DisjunctiveNormalForm', [], 'DisjunctiveNormalForm.dtc'),
+    ('power', [], 'power.dtc'),
+    ('power_separate', [], 'power_separate.dtc'),
+    ('g_12_2_0.4_1_3_2', [], (12, 2, 0.4, 1, 3, 2)),
+    ('g_9_2_0.3_1_13_3', [], (9, 2, 0.3, 1, 13, 3)),
+    ('g_12_2_0.5_3_5_2', [], (12, 2, 0.5, 3, 5, 2)),
+    ('g_6_3_0.4_1_3_2', [], (6, 3, 0.4, 1, 3, 2)),
+    ('g_7_3_0.4_1_2_1', [], (7, 3, 0.4, 1, 2, 1)),
+    ('g_5_4_0.5_1_5_1', [], (5, 4, 0.5, 1, 5, 1)),
+    ('g_16_2_0.6_2_3_3-q', ['-q'], (16, 2, 0.6, 2, 3, 3)),
+    ('g_16_2_0.6_2_3_3', [], (16, 2, 0.6, 2, 3, 3)),
+]
+
+TIMEOUT = 600
+SLOWER = 1.25
+
+
+def run(dtc, flags, path):
+    """Wall seconds, peak RSS (KB) and D of one compile, D is '-' when there is none."""
+    t = time.time()
+    with tempfile.TemporaryFile() as out:
+        p = subprocess.Popen([dtc] + flags + [path], stdout=out, stderr=subprocess.DEVNULL)
+        # reap it ourselves, wait4 gives the rusage of just this child
+        killed = False
+        while True:
+            pid, _, ru = os.wait4(p.pid, os.WNOHANG)
+            if pid:
+                break
+            if not killed and time.time() - t > TIMEOUT:
+                p.kill()
+                killed = True
+            time.sleep(0.005)
+        p.returncode = 0
+        secs = time.time() - t
+        out.seek(0)
+        d = [l for l in out.read().decode().split('\n') if l.startswith('D,')]
+    if killed:
+        return secs, ru.ru_maxrss, 'timeout'
+    return secs, ru.ru_maxrss, d[0][2:] if d else '-'
+
+
+def load(path):
+    """name -> (seconds, rss, D) of the baseline file."""
+    r = {}
+    if os.path.exists(path):
+        with open(path) as f:
+            for line in f:
+                if line.startswith('#') or not line.strip():
+                    continue
+                name, secs, rss, d = line.split()
+                r[name] = (float(secs), int(rss), d)
+    return r
+
+
+def main():
+    args = sys.argv[1:]
+    update = args[:1] == ['--update']
+    if update:
+        args = args[1:]
+    if len(args) != 2:
+        print(__doc__.strip().split('\n\n')[1], file=sys.stderr)
+        sys.exit(1)
+    dtc, path = os.path.abspath(args[0]), args[1]
+    here = os.path.dirname(os.path.abspath(__file__))
+    base = {} if update else load(path)
+    results = []
+    bad = 0
+    with tempfile.TemporaryDirectory() as tmp:
+        print('%-22s %9s %9s %5s' % ('table', 'seconds', 'rss KB', 'D'))
+        for name, flags, src in CORPUS:
+            if isinstance(src, tuple):
+                table = os.path.join(tmp, name + '.dtc')
+                with open(table, 'w') as f:
+                    f.write(gen.generate(*src))
+            else:
+                table = os.path.join(here, src)
+            secs, rss, d = run(dtc, flags, table)
+            results.append((name, secs, rss, d))
+            note = ''
+            if name in base:
+                bsecs, brss, bd = base[name]
+                if d != bd:
+                    note = ' D was %s' % bd
+                    bad = 1
+                elif secs > bsecs * SLOWER and secs - bsecs > 0.05:
+                    note = ' slower (%.2fx)' % (secs / bsecs)
+                elif brss and rss > brss * SLOWER:
+                    note = ' larger (%.2fx)' % (rss / brss)
+            print('%-22s %9.3f %9d %5s%s' % (name, secs, rss, d, note))
+    if not base:
+        with open(path, 'w') as f:
+            f.write('# table seconds rssKB D\n')
+            for r in results:
+                f.write('%s %.3f %d %s\n' % r)
+        print('baseline written to %s' % path)
+    sys.exit(bad)
+
+
+if __name__ == '__main__':
+    main()
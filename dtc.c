@@ -18,11 +18,25 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+/* POSIX.1-2008: sigaction, clock_gettime, posix_madvise */
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <limits.h>
+#include <float.h>
 #include <string.h>
+#include <ctype.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <signal.h>
+#include <time.h>
+#if DTC_PTHREAD
+#include <pthread.h>
+#endif
 #include "csv.h"
 
 /********************************************************************************/
@@ -30,6 +44,9 @@
 typedef struct sym sym_t;
 
 struct sym {
+  unsigned long h; /* of v, for syms_t */
+  const unsigned char *e; /* CSV encoding of v (maybe v), set when interned */
+  unsigned int en;
   unsigned int n;
   unsigned char v[1]; /* extended when allocated to n */
 };
@@ -52,9 +69,15 @@ symNew(
     free(r);
     return (0);
   }
+  r->e = 0;
+  r->en = 0;
   r->n = l;
-  while (l--)
+  r->h = 2166136261UL;
+  while (l--) {
     r->v[l] = *(v + l);
+    r->h = (r->h ^ r->v[l]) * 16777619UL;
+  }
+  r->h ^= r->h >> 15;
   return (r);
 }
 
@@ -76,9 +99,33 @@ symFre(
 ){
   if (!sym)
     return;
+  if (sym->e != sym->v)
+    free((void *)sym->e);
   free((void *)sym);
 }
 
+/* set the CSV encoding of sym for output */
+static int
+symEnc(
+  const sym_t *sym
+){
+  unsigned char *e;
+  int l;
+
+  if (!(e = malloc(sym->n * 2 + 2))
+   || (l = csvEncodeValue(e, sym->n * 2 + 2, sym->v, sym->n)) <= 0) {
+    free(e);
+    return (1);
+  }
+  if ((unsigned int)l == sym->n && !memcmp(e, sym->v, l)) {
+    free(e);
+    e = (unsigned char *)sym->v;
+  }
+  *((const unsigned char **)&sym->e) = e;
+  *((unsigned int *)&sym->en) = l;
+  return (0);
+}
+
 static int
 symCmp(
   const sym_t *e1
@@ -106,9 +153,12 @@ symCmp(
 
 typedef struct syms syms_t;
 
+/* interned, v in the order added with an open addressed (linear probe) index h, m a power of two */
 struct syms {
   const sym_t **v;
   unsigned int n;
+  const sym_t **h;
+  unsigned int m;
 };
 
 static syms_t *
@@ -118,6 +168,7 @@ symsNew(
   return (calloc(1, sizeof (syms_t)));
 }
 
+#if 0 /* only used by original bsearch/qsort technique */
 static int
 symsSchCmp(
   const sym_t *k
@@ -133,14 +184,58 @@ symsSrtCmp(
 ){
   return (symCmp(*e1, *e2));
 }
+#endif
+
+/* grow the index when more than half full */
+static int
+symsGrw(
+  syms_t *syms
+){
+  const sym_t **h;
+  unsigned int m;
+  unsigned int i;
+  unsigned int j;
+
+  m = syms->m ? syms->m * 2 : 256;
+  if (m < syms->m
+   || !(h = calloc(m, sizeof (*h))))
+    return (1);
+  for (i = 0; i < syms->n; ++i) {
+    for (j = (*(syms->v + i))->h & (m - 1); *(h + j); j = (j + 1) & (m - 1));
+    *(h + j) = *(syms->v + i);
+  }
+  free(syms->h);
+  syms->h = h;
+  syms->m = m;
+  return (0);
+}
 
 static const sym_t *
 symsAdd(
   syms_t *syms
  ,const sym_t *sym
 ){
-  const sym_t **r;
+  const sym_t *e;
   void *v;
+  unsigned int i;
+
+  if (!sym || !syms)
+    return (0);
+  if ((syms->n + 1) * 2 > syms->m
+   && symsGrw(syms))
+    return (0);
+  for (i = sym->h & (syms->m - 1); (e = *(syms->h + i)); i = (i + 1) & (syms->m - 1))
+    if (e->h == sym->h && !symCmp(e, sym))
+      return (e);
+  if (symEnc(sym)
+   || !(v = realloc(syms->v, (syms->n + 1) * sizeof (*syms->v))))
+    return (0);
+  syms->v = v;
+  *(syms->v + syms->n++) = sym;
+  *(syms->h + i) = sym;
+  return (sym);
+#if 0 /* original bsearch/qsort technique - O(n log n) per insert */
+  const sym_t **r;
 
   if (!sym || !syms)
     return (0);
@@ -152,6 +247,7 @@ symsAdd(
   *(syms->v + syms->n++) = sym;
   qsort(syms->v, syms->n, sizeof (*syms->v), (int(*)(const void *, const void *))symsSrtCmp);
   return (sym);
+#endif
 }
 
 #if DTC_DEBUG
@@ -180,11 +276,289 @@ symsFre(
   while (syms->n--)
     symFre(*(syms->v + syms->n));
   free(syms->v);
+  free(syms->h);
   free(syms);
 }
 
 /********************************************************************************/
 
+typedef struct are are_t;
+typedef struct areBlk areBlk_t;
+
+/* region allocator, freed all at once or back to a mark */
+struct are {
+  areBlk_t *b; /* current block, linked to the older ones */
+  areBlk_t *f; /* free blocks of z */
+  unsigned long o; /* used of b */
+  unsigned long n; /* bytes of b and the older ones */
+  unsigned long fn; /* bytes of f */
+  unsigned long z; /* bytes of a block, ARE_B when 0 */
+};
+
+struct areBlk {
+  areBlk_t *p;
+  unsigned long n;
+  union {
+    void *p;
+    long l;
+    double d;
+  } v[1]; /* extended when allocated to n bytes */
+};
+
+#define ARE_B (64 * 1024UL)
+#define ARE_A (sizeof (((areBlk_t *)0)->v[0]))
+
+typedef struct {
+  areBlk_t *b;
+  unsigned long o;
+} areMrk_t;
+
+static void *
+areAlc(
+  are_t *are
+ ,unsigned long n
+){
+  areBlk_t *b;
+  void *r;
+  unsigned long z;
+
+  n = (n + ARE_A - 1) / ARE_A * ARE_A;
+  if (!are->b || are->b->n - are->o < n) {
+    z = are->z ? are->z : ARE_B;
+    if (n <= z && are->f) {
+      b = are->f;
+      are->f = b->p;
+      are->fn -= b->n;
+    } else if (!(b = malloc((unsigned long)&((areBlk_t *)0)->v + (n > z ? n : z))))
+      return (0);
+    else
+      b->n = n > z ? n : z;
+    b->p = are->b;
+    are->b = b;
+    are->o = 0;
+    are->n += b->n;
+  }
+  r = (unsigned char *)are->b->v + are->o;
+  are->o += n;
+  return (r);
+}
+
+static void *
+areClc(
+  are_t *are
+ ,unsigned long n
+){
+  void *r;
+
+  if ((r = areAlc(are, n)))
+    memset(r, 0, n);
+  return (r);
+}
+
+static areMrk_t
+areMrk(
+  const are_t *are
+){
+  areMrk_t r;
+
+  r.b = are->b;
+  r.o = are->o;
+  return (r);
+}
+
+/* release everything allocated after the mark */
+static void
+areRst(
+  are_t *are
+ ,areMrk_t m
+){
+  areBlk_t *b;
+
+  while (are->b != m.b) {
+    b = are->b;
+    are->b = b->p;
+    are->n -= b->n;
+    if (b->n == (are->z ? are->z : ARE_B)) {
+      b->p = are->f;
+      are->f = b;
+      are->fn += b->n;
+    } else
+      free(b);
+  }
+  are->o = m.o;
+}
+
+/* move the blocks of src to dst (which is not reset), src is then empty */
+static void
+areMov(
+  are_t *dst
+ ,are_t *src
+){
+  areBlk_t *b;
+
+  if (!src->b)
+    return;
+  if (!dst->b) {
+    dst->b = src->b;
+    dst->o = src->o;
+  } else {
+    for (b = src->b; b->p; b = b->p);
+    b->p = dst->b->p;
+    dst->b->p = src->b;
+  }
+  dst->n += src->n;
+  src->b = 0;
+  src->o = 0;
+  src->n = 0;
+}
+
+/* bytes in the blocks */
+static unsigned long
+areSz(
+  const are_t *are
+){
+  return (are->n + are->fn);
+}
+
+static void
+areFre(
+  are_t *are
+){
+  areBlk_t *b;
+
+  while ((b = are->b)) {
+    are->b = b->p;
+    free(b);
+  }
+  while ((b = are->f)) {
+    are->f = b->p;
+    free(b);
+  }
+  are->o = 0;
+  are->n = 0;
+  are->fn = 0;
+}
+
+/********************************************************************************/
+
+typedef struct bits bits_t;
+
+/* word packed set of dense ids (of val_t or inf_t) */
+struct bits {
+  unsigned long *v;
+  unsigned int n; /* words */
+};
+
+#define BITS_W (sizeof (unsigned long) * 8)
+
+static bits_t *
+bitsNew(
+  unsigned int n
+){
+  bits_t *r;
+
+  if (!(r = calloc(1, sizeof (*r))))
+    return (0);
+  r->n = (n + BITS_W - 1) / BITS_W;
+  if (!(r->v = calloc(r->n ? r->n : 1, sizeof (*r->v)))) {
+    free(r);
+    return (0);
+  }
+  return (r);
+}
+
+static bits_t *
+bitsAre(
+  are_t *are
+ ,unsigned int n
+){
+  bits_t *r;
+
+  if (!(r = areAlc(are, sizeof (*r))))
+    return (0);
+  r->n = (n + BITS_W - 1) / BITS_W;
+  if (!(r->v = areClc(are, (r->n ? r->n : 1) * sizeof (*r->v))))
+    return (0);
+  return (r);
+}
+
+static void
+bitsFre(
+  bits_t *bits
+){
+  if (!bits)
+    return;
+  free(bits->v);
+  free(bits);
+}
+
+static void
+bitsClr(
+  bits_t *bits
+){
+  memset(bits->v, 0, bits->n * sizeof (*bits->v));
+}
+
+static void
+bitsSet(
+  bits_t *bits
+ ,unsigned int i
+){
+  *(bits->v + i / BITS_W) |= 1UL << i % BITS_W;
+}
+
+static int
+bitsTst(
+  const bits_t *bits
+ ,unsigned int i
+){
+  return (*(bits->v + i / BITS_W) >> i % BITS_W & 1);
+}
+
+/* bits1 |= bits2 */
+static void
+bitsOr(
+  bits_t *bits1
+ ,const bits_t *bits2
+){
+  unsigned int i;
+
+  for (i = 0; i < bits1->n; ++i)
+    *(bits1->v + i) |= *(bits2->v + i);
+}
+
+/* intersection is not empty */
+static int
+bitsAnd(
+  const bits_t *bits1
+ ,const bits_t *bits2
+){
+  unsigned long w;
+  unsigned int i;
+
+  for (w = i = 0; i < bits1->n; ++i)
+    w |= *(bits1->v + i) & *(bits2->v + i);
+  return (w != 0);
+}
+
+/* population count of intersection */
+static unsigned int
+bitsAndCnt(
+  const bits_t *bits1
+ ,const bits_t *bits2
+){
+  unsigned long w;
+  unsigned int i;
+  unsigned int r;
+
+  for (r = i = 0; i < bits1->n; ++i)
+    for (w = *(bits1->v + i) & *(bits2->v + i); w; w &= w - 1)
+      ++r;
+  return (r);
+}
+
+/********************************************************************************/
+
 typedef struct nam nam_t;
 
 #if DTC_DEBUG
@@ -209,6 +583,15 @@ struct val {
   const nam_t *nam;
   const sym_t *sym;
   infs_t *infs;
+  bits_t *ib; /* infs by inf_t id */
+  bits_t *ob; /* union of ib of the other vals of nam */
+  unsigned int id; /* dense, in valCmp order */
+  unsigned int rnk; /* id + 1, 0 until csvIdx */
+  unsigned int bal; /* valsInfsCmp keys, difference of infs with the other vals of nam */
+  unsigned int dly; /* and the smaller of them */
+  double p; /* of val among the values of nam, by the profile (-e) */
+  unsigned int cst; /* of testing val, the cost of nam (-w), 1 until then */
+  const val_t *eq; /* first val of nam interchangeable with it (valsEq), else 0 */
 };
 
 static const val_t *
@@ -248,6 +631,8 @@ valFre(
   if (!val)
     return;
   infsRefFre(val->infs);
+  bitsFre(val->ib);
+  bitsFre(val->ob);
   free((void *)val);
 }
 
@@ -260,6 +645,8 @@ valCmp(
 
   if (e1 == e2)
     return (0);
+  if (e1->rnk && e2->rnk)
+    return (e1->rnk < e2->rnk ? -1 : 1);
   if ((r = namCmp(e1->nam, e2->nam)))
     return (r);
   return (symCmp(e1->sym, e2->sym));
@@ -281,6 +668,7 @@ valsNew(
   return (calloc(1, sizeof (vals_t)));
 }
 
+#if 0 /* only used by original bsearch/qsort technique */
 static int
 valsSchCmp(
   const val_t *k
@@ -288,6 +676,7 @@ valsSchCmp(
 ){
   return (valCmp(k, *e));
 }
+#endif
 
 static int
 valsSrtCmp(
@@ -376,30 +765,56 @@ valsFre(
   free(vals);
 }
 
-static vals_t *
-valsRefDup(
+static void
+valsRefFre(
+  vals_t *vals
+){
+  if (!vals)
+    return;
+  free(vals->v);
+  free(vals);
+}
+
+/* sum of the cst of vals, no path tests more */
+static unsigned int
+valsCst(
   const vals_t *vals
+){
+  unsigned int r;
+  unsigned int i;
+
+  for (r = i = 0; i < vals->n; ++i)
+    r += (*(vals->v + i))->cst;
+  return (r);
+}
+
+/* empty, with room for m */
+static vals_t *
+valsAre(
+  are_t *are
+ ,unsigned int m
 ){
   vals_t *r;
 
-  if (!(r = valsNew())
-   || !(r->v = malloc(vals->n * sizeof (*r->v)))) {
-    free(r);
+  if (!(r = areAlc(are, sizeof (*r)))
+   || !(r->v = areAlc(are, (m ? m : 1) * sizeof (*r->v))))
     return (0);
-  }
-  for (r->n = 0; r->n < vals->n; ++r->n)
-    *(r->v + r->n) = *(vals->v + r->n);
+  r->n = 0;
   return (r);
 }
 
-static void
-valsRefFre(
-  vals_t *vals
+static vals_t *
+valsAreDup(
+  are_t *are
+ ,const vals_t *vals
 ){
-  if (!vals)
-    return;
-  free(vals->v);
-  free(vals);
+  vals_t *r;
+
+  if (!(r = valsAre(are, vals->n)))
+    return (0);
+  memcpy(r->v, vals->v, vals->n * sizeof (*r->v));
+  r->n = vals->n;
+  return (r);
 }
 
 static int
@@ -433,6 +848,7 @@ valsCmp(
 struct nam {
   const sym_t *sym;
   vals_t *vals;
+  unsigned int rnk; /* namCmp order from 1, 0 until csvIdx */
 };
 
 static const nam_t *
@@ -495,6 +911,8 @@ namCmp(
 ){
   if (e1 == e2)
     return (0);
+  if (e1->rnk && e2->rnk)
+    return (e1->rnk < e2->rnk ? -1 : 1);
   return (symCmp(e1->sym, e2->sym));
 }
 
@@ -586,8 +1004,12 @@ typedef struct inf inf_t;
 struct inf {
   const val_t *val;
   vals_t *vals;
+  bits_t *vb; /* vals by val_t id */
   const unsigned char *fil;
   unsigned int row;
+  unsigned int id; /* dense, in infCmp order */
+  unsigned int ind; /* all vals independent */
+  unsigned int lvl; /* of the nam of val in the nam graph (csvIdx), ~0U with a cycle */
 };
 
 static const inf_t *
@@ -633,6 +1055,7 @@ infFre(
   if (!inf)
     return;
   valsRefFre(inf->vals);
+  bitsFre(inf->vb);
   free((void *)inf);
 }
 
@@ -769,30 +1192,73 @@ infsFre(
   free(infs);
 }
 
+static void
+infsRefFre(
+  infs_t *infs
+){
+  if (!infs)
+    return;
+  free(infs->v);
+  free(infs);
+}
+
+/* empty, with room for m */
 static infs_t *
-infsRefDup(
-  const infs_t *infs
+infsAre(
+  are_t *are
+ ,unsigned int m
 ){
   infs_t *r;
 
-  if (!(r = infsNew())
-   || !(r->v = malloc(infs->n * sizeof (*r->v)))) {
-    free(r);
+  if (!(r = areAlc(are, sizeof (*r)))
+   || !(r->v = areAlc(are, (m ? m : 1) * sizeof (*r->v))))
     return (0);
-  }
-  for (r->n = 0; r->n < infs->n; ++r->n)
-    *(r->v + r->n) = *(infs->v + r->n);
+  r->n = 0;
   return (r);
 }
 
-static void
-infsRefFre(
+static infs_t *
+infsAreDup(
+  are_t *are
+ ,const infs_t *infs
+){
+  infs_t *r;
+
+  if (!(r = infsAre(are, infs->n)))
+    return (0);
+  memcpy(r->v, infs->v, infs->n * sizeof (*r->v));
+  r->n = infs->n;
+  return (r);
+}
+
+/* infsAdd without growing, there must be room */
+static const inf_t *
+infsIns(
   infs_t *infs
+ ,const inf_t *inf
 ){
-  if (!infs)
-    return;
-  free(infs->v);
-  free(infs);
+  unsigned int lo;
+  unsigned int hi;
+  unsigned int mid;
+  int c;
+
+  lo = 0;
+  hi = infs->n;
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    c = infsSrtCmp(&inf, infs->v + mid);
+    if (c == 0)
+      return (*(infs->v + mid));
+    if (c < 0)
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+  if (lo < infs->n)
+    memmove(infs->v + lo + 1, infs->v + lo, (infs->n - lo) * sizeof (*infs->v));
+  *(infs->v + lo) = inf;
+  ++infs->n;
+  return (inf);
 }
 
 static int
@@ -824,6 +1290,7 @@ infsCmp(
 /********************************************************************************/
 
 struct csv {
+  FILE *err; /* of csvCb, csvFil and csvMrg */
   const unsigned char *fil;
   syms_t *syms;
   nams_t *nams;
@@ -831,8 +1298,10 @@ struct csv {
   const inf_t *inf;
   const nam_t **col;
   unsigned int coln;
+  unsigned int valn;
   int inCom;
   int inNam;
+  int noNam; /* a row came before any @name row */
 };
 
 static int
@@ -861,11 +1330,11 @@ csvCb(
       const inf_t *inf;
 
       if (!(inf = infsAdd(V->infs, V->inf))) {
-        fprintf(stderr, "infsAdd fail @%s:%u:%u(%.*s)\n", V->fil, r, c, l->l, l->s);
+        fprintf(V->err, "infsAdd fail @%s:%u:%u(%.*s)\n", V->fil, r, c, l->l, l->s);
         return (1);
       }
       if (inf != V->inf) {
-        fprintf(stderr, "duplicate inf @%s:%u @%s:%u\n", inf->fil, inf->row, V->inf->fil, V->inf->row);
+        fprintf(V->err, "duplicate inf @%s:%u @%s:%u\n", inf->fil, inf->row, V->inf->fil, V->inf->row);
         return (1);
       }
       V->inf = 0;
@@ -880,11 +1349,11 @@ csvCb(
       break;
     if (!l->l) {
       if (V->inNam) {
-        fprintf(stderr, "Empty name in '@' row @%s:%u:%u\n", V->fil, r, c);
+        fprintf(V->err, "Empty name in '@' row @%s:%u:%u\n", V->fil, r, c);
         return (1);
       }
       if (!c) {
-        fprintf(stderr, "Empty value @%s:%u:%u\n", V->fil, r, c);
+        fprintf(V->err, "Empty value @%s:%u:%u\n", V->fil, r, c);
         return (1);
       }
       break; /* don't care */
@@ -896,7 +1365,7 @@ csvCb(
       }
       if (*l->s == '@') {
         if (l->l < 2) {
-          fprintf(stderr, "Empty @name @%s:%u:%u\n", V->fil, r, c);
+          fprintf(V->err, "Empty @name @%s:%u:%u\n", V->fil, r, c);
           return (1);
         }
         V->coln = 0;
@@ -907,7 +1376,7 @@ csvCb(
      || (i = csvDecodeValue(d, l->l, l->s, l->l)) <= 0
      || i > (int)l->l) {
       free(d);
-      fprintf(stderr, "csvDecodeValue @%s:%u:%u(%.*s)\n", V->fil, r, c, l->l, l->s);
+      fprintf(V->err, "csvDecodeValue @%s:%u:%u(%.*s)\n", V->fil, r, c, l->l, l->s);
       return (1);
     }
     if (V->inNam) {
@@ -915,7 +1384,7 @@ csvCb(
        || !(cv = symsAdd(V->syms, sym))) {
         symFre(sym);
         free(d);
-        fprintf(stderr, "symNew/symsAdd fail @%s:%u:%u(%.*s)\n", V->fil, r, c, l->l, l->s);
+        fprintf(V->err, "symNew/symsAdd fail @%s:%u:%u(%.*s)\n", V->fil, r, c, l->l, l->s);
         return (1);
       }
       free(d);
@@ -926,7 +1395,7 @@ csvCb(
       if (!(nam = namNew(sym))
        || !(cv = namsAdd(V->nams, nam))) {
         namFre(nam);
-        fprintf(stderr, "namNew/namsAdd fail @%s:%u:%u(%.*s)\n", V->fil, r, c, l->l, l->s);
+        fprintf(V->err, "namNew/namsAdd fail @%s:%u:%u(%.*s)\n", V->fil, r, c, l->l, l->s);
         return (1);
       }
       if (cv != nam) {
@@ -934,20 +1403,26 @@ csvCb(
         nam = cv;
       }
       if (!(tv = realloc(V->col, (V->coln + 1) * sizeof (*V->col)))) {
-        fprintf(stderr, "realloc fail @%s:%u:%u(%.*s)\n", V->fil, r, c, l->l, l->s);
+        fprintf(V->err, "realloc fail @%s:%u:%u(%.*s)\n", V->fil, r, c, l->l, l->s);
         return (1);
       }
       V->col = tv;
       for (j = 0; j < V->coln && nam != *(V->col + j); ++j);
       if (j < V->coln) {
-        fprintf(stderr, "duplicate name @%s:%u:%u(%.*s)\n", V->fil, r, c, l->l, l->s);
+        fprintf(V->err, "duplicate name @%s:%u:%u(%.*s)\n", V->fil, r, c, l->l, l->s);
         return (1);
       }
       *(V->col + V->coln++) = nam;
       break;
     }
+    if (!V->coln) {
+      V->noNam = 1;
+      fprintf(V->err, "no @name row before @%s:%u:%u(%.*s)\n", V->fil, r, c, l->l, l->s);
+      free(d);
+      return (1);
+    }
     if (c > V->coln) {
-      fprintf(stderr, "excess CSValue @%s:%u:%u(%.*s)\n", V->fil, r, c, l->l, l->s);
+      fprintf(V->err, "excess CSValue @%s:%u:%u(%.*s)\n", V->fil, r, c, l->l, l->s);
       free(d);
       return (1);
     }
@@ -955,7 +1430,7 @@ csvCb(
      || !(cv = symsAdd(V->syms, sym))) {
       symFre(sym);
       free(d);
-      fprintf(stderr, "symNew/symsAdd fail @%s:%u:%u(%.*s)\n", V->fil, r, c, l->l, l->s);
+      fprintf(V->err, "symNew/symsAdd fail @%s:%u:%u(%.*s)\n", V->fil, r, c, l->l, l->s);
       return (1);
     }
     free(d);
@@ -966,7 +1441,7 @@ csvCb(
     if (!(val = valNew(*(V->col + c), sym))
      || !(cv = valsAdd((*(V->col + c))->vals, val))) {
       valFre(val);
-      fprintf(stderr, "valNew/valsAdd fail @%s:%u:%u ,%.*s,\n", V->fil, r, c, l->l, l->s);
+      fprintf(V->err, "valNew/valsAdd fail @%s:%u:%u ,%.*s,\n", V->fil, r, c, l->l, l->s);
       return (1);
     }
     if (cv != val) {
@@ -975,17 +1450,17 @@ csvCb(
     }
     if (!c) {
       if (!(V->inf = infNew(val, V->fil, r))) {
-        fprintf(stderr, "infNew fail @%s:%u:%u(%.*s)\n", V->fil, r, c, l->l, l->s);
+        fprintf(V->err, "infNew fail @%s:%u:%u(%.*s)\n", V->fil, r, c, l->l, l->s);
         return (1);
       }
     } else {
       if (!(cv = valsAdd(V->inf->vals, val))) {
-        fprintf(stderr, "valsAdd fail @%s:%u:%u(%.*s)\n", V->fil, r, c, l->l, l->s);
+        fprintf(V->err, "valsAdd fail @%s:%u:%u(%.*s)\n", V->fil, r, c, l->l, l->s);
         return (1);
       }
       if (cv != val) {
         valFre(val);
-        fprintf(stderr, "duplicate val @%s:%u:%u(%.*s)\n", V->fil, r, c, l->l, l->s);
+        fprintf(V->err, "duplicate val @%s:%u:%u(%.*s)\n", V->fil, r, c, l->l, l->s);
         return (1);
       }
     }
@@ -995,6 +1470,26 @@ csvCb(
 #undef V
 }
 
+static struct csv *
+csvNew(
+  FILE *err
+){
+  struct csv *r;
+
+  if (!(r = calloc(1, sizeof (*r))))
+    return (0);
+  if (!(r->syms = symsNew())
+   || !(r->nams = namsNew())
+   || !(r->infs = infsNew())) {
+    symsFre(r->syms);
+    namsFre(r->nams);
+    free(r);
+    return (0);
+  }
+  r->err = err;
+  return (r);
+}
+
 static void
 csvFre(
   struct csv *v
@@ -1009,1089 +1504,4150 @@ csvFre(
   free(v);
 }
 
-static void
-csvPrt(
-  const unsigned char *v
- ,unsigned char n
-){
-  unsigned char *e;
-  int l;
+/* parse file fil (mapped, not copied) into v, the @name row in force at the end of one file holds in the next */
+static int
+csvFil(
+  struct csv *v
+ ,const char *prg
+ ,const char *fil
+){
+  struct stat st;
+  const unsigned char *bf;
+  int fd;
+  int r;
 
-  if (!(e = malloc(n * 2))
-   || (l = csvEncodeValue(e, n * 2, v, n)) <= 0)
-    printf("%.*s", (int)n, v);
-  else
-    printf("%.*s", l, e);
-  free(e);
+  if ((fd = open(fil, O_RDONLY)) < 0) {
+    fprintf(v->err, "%s: Can't open %s\n", prg, fil);
+    return (1);
+  }
+  if (fstat(fd, &st)) {
+    fprintf(v->err, "%s: data fail on %s\n", prg, fil);
+    close(fd);
+    return (1);
+  }
+  /* the CSV parser's lengths are int */
+  if (st.st_size > INT_MAX) {
+    fprintf(v->err, "%s: %s is larger than %d bytes\n", prg, fil, INT_MAX);
+    close(fd);
+    return (1);
+  }
+  bf = (const unsigned char *)"";
+  if (st.st_size
+   && (bf = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED) {
+    fprintf(v->err, "%s: data fail on %s\n", prg, fil);
+    close(fd);
+    return (1);
+  }
+  close(fd);
+  if (st.st_size)
+    posix_madvise((void *)bf, st.st_size, POSIX_MADV_SEQUENTIAL);
+  v->fil = (const unsigned char *)fil;
+  v->inCom = 0;
+  v->inNam = 0;
+  if ((r = csvParse(csvCb, bf, st.st_size, v) != st.st_size))
+    fprintf(v->err, "%s: CSV parse fail on %s\n", prg, fil);
+  if (st.st_size)
+    munmap((void *)bf, st.st_size);
+  return (r);
 }
 
-/********************************************************************************/
+#if DTC_PTHREAD
+/* of s in v, a copy interned if new */
+static const sym_t *
+csvMrgSym(
+  struct csv *v
+ ,const sym_t *s
+){
+  const sym_t *sym;
+  const sym_t *r;
+
+  if (!(sym = symNew(s->v, s->n))
+   || !(r = symsAdd(v->syms, sym))) {
+    symFre(sym);
+    return (0);
+  }
+  if (r != sym)
+    symFre(sym);
+  return (r);
+}
 
-/* transitive closure */
+/* rows of a file in order */
 static int
-infsValTrnAdd(
-  const val_t *val
- ,const infs_t *infs
- ,const vals_t *vals
- ,infs_t *r
+csvMrgCmp(
+  const inf_t **e1
+ ,const inf_t **e2
 ){
-  vals_t *v1;
-  const val_t *d;
-  unsigned int n;
+  return ((*e1)->row < (*e2)->row ? -1 : (*e1)->row > (*e2)->row);
+}
+
+/* merge the tables of file s into v, as if parsed after them, the @name row of s if any holds after */
+static int
+csvMrg(
+  struct csv *v
+ ,struct csv *s
+ ,const char *prg
+){
+  const nam_t **a; /* of v by the nams of s */
+  const val_t **m; /* of v by the vals of s in order */
+  const inf_t **o; /* s infs in row order, the first duplicate is the one parsing finds */
+  const sym_t *sym;
+  const nam_t *nam;
+  const nam_t *n;
+  const val_t *val;
+  const val_t *w;
+  const inf_t *inf;
+  const inf_t *f;
+  void *tv;
+  unsigned int k;
   unsigned int i;
   unsigned int j;
-  unsigned int k;
 
-  if (!(v1 = valsNew())
-   || !(valsAdd(v1, val))) {
-    valsRefFre(v1);
-    return (1);
-  }
-  for (i = 0; i < r->n; ++i)
-    if (!valsAdd(v1, (*(r->v + i))->val)) {
-      valsRefFre(v1);
-      return (1);
+  for (k = i = 0; i < s->nams->n; ++i)
+    k += (*(s->nams->v + i))->vals->n;
+  m = 0;
+  o = 0;
+  if (!(a = malloc((s->nams->n ? s->nams->n : 1) * sizeof (*a)))
+   || !(m = malloc((k ? k : 1) * sizeof (*m)))
+   || !(o = malloc((s->infs->n ? s->infs->n : 1) * sizeof (*o))))
+    goto fail;
+  memcpy(o, s->infs->v, s->infs->n * sizeof (*o));
+  qsort(o, s->infs->n, sizeof (*o), (int(*)(const void *, const void *))csvMrgCmp);
+  for (k = i = 0; i < s->nams->n; ++i) {
+    n = *(s->nams->v + i);
+    nam = 0;
+    if (!(sym = csvMrgSym(v, n->sym))
+     || !(nam = namNew(sym))
+     || !(n = namsAdd(v->nams, nam))) {
+      namFre(nam);
+      goto fail;
     }
-  for (;;) {
-    n = v1->n;
-    for (i = 0; i < infs->n; ++i) {
-      for (j = 0; j < (*(infs->v + i))->vals->n; ++j) {
-        d = *((*(infs->v + i))->vals->v + j);
-        if (bsearch(d, v1->v, v1->n, sizeof (*v1->v), (int(*)(const void *, const void *))valsSchCmp))
-          continue;
-        for (k = 0; k < v1->n; ++k)
-          if ((*(v1->v + k))->nam == d->nam)
-            goto continue_i;
-        if (bsearch(d, vals->v, vals->n, sizeof (*vals->v), (int(*)(const void *, const void *))valsSchCmp))
-          goto continue_i;
-        for (k = 0; k < infs->n; ++k)
-          if ((*(infs->v + k))->val->nam == d->nam)
-            break;
-        if (k < infs->n)
-          goto continue_i;
+    if (n != nam)
+      namFre(nam);
+    *(a + i) = n;
+    for (j = 0; j < (*(s->nams->v + i))->vals->n; ++j, ++k) {
+      w = *((*(s->nams->v + i))->vals->v + j);
+      /* s ids are free until csvIdx */
+      *((unsigned int *)&w->id) = k;
+      val = 0;
+      if (!(sym = csvMrgSym(v, w->sym))
+       || !(val = valNew(n, sym))
+       || !(*(m + k) = valsAdd(n->vals, val))) {
+        valFre(val);
+        goto fail;
       }
-      if (!infsAdd(r, *(infs->v + i))
-       || !valsAdd(v1, (*(infs->v + i))->val)) {
-        valsRefFre(v1);
-        return (1);
+      if (*(m + k) != val)
+        valFre(val);
+    }
+  }
+  if (s->coln) {
+    if (!(tv = realloc(v->col, s->coln * sizeof (*v->col))))
+      goto fail;
+    v->col = tv;
+    for (j = 0; j < s->coln; ++j) {
+      for (i = 0; *(s->nams->v + i) != *(s->col + j); ++i);
+      *(v->col + j) = *(a + i);
+    }
+    v->coln = s->coln;
+  }
+  for (i = 0; i < s->infs->n; ++i) {
+    f = *(o + i);
+    if (!(inf = infNew(*(m + f->val->id), f->fil, f->row)))
+      goto fail;
+    for (j = 0; j < f->vals->n; ++j)
+      if (!valsAdd(inf->vals, *(m + (*(f->vals->v + j))->id))) {
+        infFre(inf);
+        goto fail;
       }
-continue_i:;
+    if (!(f = infsAdd(v->infs, inf))) {
+      infFre(inf);
+      goto fail;
+    }
+    if (f != inf) {
+      fprintf(v->err, "duplicate inf @%s:%u @%s:%u\n", f->fil, f->row, inf->fil, inf->row);
+      fprintf(v->err, "%s: CSV parse fail on %s\n", prg, inf->fil);
+      infFre(inf);
+      free(o);
+      free(m);
+      free(a);
+      return (1);
     }
-    if (v1->n == n)
-      break;
   }
-  valsRefFre(v1);
+  free(o);
+  free(m);
+  free(a);
   return (0);
+fail:
+  fprintf(v->err, "%s: alloc fail\n", prg);
+  free(o);
+  free(m);
+  free(a);
+  return (1);
 }
 
-static int
-infsVal(
-  const val_t *val
- ,const infs_t *infs
- ,infs_t *r
+/* files parsed by threads, each into its own csv */
+typedef struct {
+  pthread_mutex_t m;
+  struct csv **c;
+  int *r;
+  const char *prg;
+  char **fil;
+  unsigned int n;
+  unsigned int i;
+} prs_t;
+
+static void *
+prsWrk(
+  void *v
 ){
-  vals_t *v;
+#define P ((prs_t *)v)
+  FILE *err;
   unsigned int i;
-  unsigned int j;
 
-  v = 0;
-  if (!(v = valsNew())
-   || !(valsAdd(v, val))) {
-    valsRefFre(v);
-    return (1);
+  for (;;) {
+    pthread_mutex_lock(&P->m);
+    i = P->i++;
+    pthread_mutex_unlock(&P->m);
+    if (i >= P->n)
+      break;
+    /* the messages are kept for main to show in file order */
+    if (!(err = tmpfile()))
+      err = stderr;
+    if (!(*(P->c + i) = csvNew(err))) {
+      if (err != stderr)
+        fclose(err);
+      *(P->r + i) = 2;
+    } else
+      *(P->r + i) = csvFil(*(P->c + i), P->prg, *(P->fil + i));
   }
-  for (i = 0; i < v->n; ++i)
-    for (j = 0; j < infs->n; ++j)
-      if (bsearch(*(v->v + i)
-          ,(*(infs->v + j))->vals->v
-          ,(*(infs->v + j))->vals->n
-          ,sizeof (*(*(infs->v + j))->vals->v)
-          ,(int(*)(const void *, const void *))valsSchCmp
-          )
-       && !infsAdd(r, *(infs->v + j))) {
-        valsRefFre(v);
-        infsRefFre(r);
-        return (1);
-      }
-  valsRefFre(v);
   return (0);
+#undef P
 }
 
-/* independent values */
-static vals_t *
-namsInd(
-  const nams_t *nams
- ,const infs_t *infs
+/* csv of n files parsed on j threads and merged in order, as csvFil of each in turn */
+static struct csv *
+csvPar(
+  const char *prg
+ ,char **fil
+ ,unsigned int n
+ ,unsigned int j
 ){
-  vals_t *r;
+  prs_t p;
+  struct csv *r;
+  pthread_t *t;
   unsigned int i;
-  unsigned int j;
+  unsigned int k;
+  int b;
+  int c;
 
-  if (!(r = valsNew()))
+  r = 0;
+  p.prg = prg;
+  p.fil = fil;
+  p.n = n;
+  p.i = 0;
+  t = 0;
+  if (!(p.c = calloc(n, sizeof (*p.c)))
+   || !(p.r = calloc(n, sizeof (*p.r)))
+   || !(t = malloc((j < n ? j : n) * sizeof (*t)))
+   || pthread_mutex_init(&p.m, 0)) {
+    fprintf(stderr, "%s: alloc fail\n", prg);
+    free(t);
+    free(p.r);
+    free(p.c);
     return (0);
-  for (i = 0; i < nams->n; ++i)
-    for (j = 0; j < (*(nams->v + i))->vals->n; ++j) {
-      if (!bsearch(*((*(nams->v + i))->vals->v + j)
-          ,infs->v
-          ,infs->n
-          ,sizeof (*infs->v)
-          ,(int(*)(const void *, const void *))infsValSchCmp
-          )
-       && valsAdd(r, *((*(nams->v + i))->vals->v + j)) != *((*(nams->v + i))->vals->v + j)) {
-          valsRefFre(r);
-          return (0);
+  }
+  for (i = 0; i < j && i < n && !pthread_create(t + i, 0, prsWrk, &p); ++i);
+  /* without threads this one does them all */
+  if (!i)
+    prsWrk(&p);
+  for (k = 0; k < i; ++k)
+    pthread_join(*(t + k), 0);
+  pthread_mutex_destroy(&p.m);
+  free(t);
+  /* a failed file is merged up to where it failed, the first error is the same as csvFil in turn */
+  for (b = 0, i = 0; i < n; ++i) {
+    if (b)
+      continue;
+    if (*(p.r + i) == 2) {
+      fprintf(stderr, "%s: alloc fail\n", prg);
+      b = 1;
+    } else if (!r && !*(p.r + i)) {
+      r = *(p.c + i);
+      if (r->err != stderr)
+        fclose(r->err);
+      r->err = stderr;
+    } else if (r && *(p.r + i) && (*(p.c + i))->noNam) {
+      /* its first rows are of the @name row of the files before, parse it after them */
+      if (csvFil(r, prg, *(fil + i)))
+        b = 1;
+    } else if (r && csvMrg(r, *(p.c + i), prg))
+      b = 1;
+    else if (*(p.r + i)) {
+      b = 1;
+      if ((*(p.c + i))->err != stderr) {
+        rewind((*(p.c + i))->err);
+        while ((c = getc((*(p.c + i))->err)) != EOF)
+          putc(c, stderr);
       }
     }
-  for (i = 0; i < r->n; ++i) {
-    if (!(*((infs_t **)&(*(r->v + i))->infs) = infsNew())
-     || infsVal(*(r->v + i), infs, (*(r->v + i))->infs)) {
-      valsRefFre(r);
-      return (0);
+  }
+  for (i = 0; i < n; ++i)
+    if (*(p.c + i) && (*(p.c + i))->err != stderr) {
+      fclose((*(p.c + i))->err);
+      (*(p.c + i))->err = stderr;
     }
+  for (i = 0; i < n; ++i)
+    if (*(p.c + i) != r)
+      csvFre(*(p.c + i));
+  free(p.r);
+  free(p.c);
+  if (b) {
+    csvFre(r);
+    return (0);
   }
   return (r);
 }
+#endif
 
+/* assign dense ids, val_t in valCmp order and inf_t in infCmp order, and inf_t vals bits */
+/* and the ranks that make valCmp and namCmp an integer compare from then on */
+/*
+ * level of each inf for infsValTrnAdd: its nam is 1 + the largest level of
+ * the nams of its vals, 0 for an independent nam, relaxed until it holds
+ * (a round per level), all ~0U when the nams do not settle (a cycle)
+ */
 static int
-valsInfsCmp(
-  const val_t **e1
- ,const val_t **e2
+csvLvl(
+  struct csv *v
 ){
-  unsigned int i1;
-  unsigned int i2;
-  unsigned int o1;
-  unsigned int o2;
+  unsigned int *l;
+  const inf_t *inf;
+  unsigned int c;
+  unsigned int k;
   unsigned int i;
+  unsigned int j;
+  unsigned int x;
 
-  /* find sum of "other" infs */
-  for (o1 = i = 0; i < (*e1)->nam->vals->n; ++i)
-    if (*((*e1)->nam->vals->v + i) != *e1)
-      o1 += (*((*e1)->nam->vals->v + i))->infs->n;
-  for (o2 = i = 0; i < (*e2)->nam->vals->n; ++i)
-    if (*((*e2)->nam->vals->v + i) != *e2)
-      o2 += (*((*e2)->nam->vals->v + i))->infs->n;
-  /* primary sort balance (smallest difference of number of inf_t) */
-  i1 = (*e1)->infs->n > o1 ? (*e1)->infs->n - o1 : o1 - (*e1)->infs->n;
-  i2 = (*e2)->infs->n > o2 ? (*e2)->infs->n - o2 : o2 - (*e2)->infs->n;
-  if (i1 < i2)
-    return (-1);
-  if (i1 > i2)
-    return (1);
-  /* secondary sort delay (largest smallest number of inf_t) */
-  i1 = (*e1)->infs->n > o1 ? o1 : (*e1)->infs->n;
-  i2 = (*e2)->infs->n > o2 ? o2 : (*e2)->infs->n;
-  if (i1 > i2)
-    return (-1);
-  if (i1 < i2)
+  if (!(l = calloc(v->nams->n ? v->nams->n : 1, sizeof (*l))))
     return (1);
+  for (c = 1, k = 0; c && k <= v->nams->n; ++k)
+    for (c = i = 0; i < v->infs->n; ++i) {
+      inf = *(v->infs->v + i);
+      for (x = j = 0; j < inf->vals->n; ++j)
+        if (*(l + (*(inf->vals->v + j))->nam->rnk - 1) > x)
+          x = *(l + (*(inf->vals->v + j))->nam->rnk - 1);
+      if (*(l + inf->val->nam->rnk - 1) < x + 1) {
+        *(l + inf->val->nam->rnk - 1) = x + 1;
+        c = 1;
+      }
+    }
+  for (i = 0; i < v->infs->n; ++i)
+    *((unsigned int *)&(*(v->infs->v + i))->lvl) = c ? ~0U : *(l + (*(v->infs->v + i))->val->nam->rnk - 1);
+  free(l);
   return (0);
 }
 
-static vals_t *
-valsSubValNam(
-  const vals_t *vals
- ,const val_t *val
- ,const infs_t *infs
+static int
+csvIdx(
+  struct csv *v
 ){
-  vals_t *r;
   unsigned int i;
   unsigned int j;
 
-  r = 0;
-  if (!vals || !val
-   || !(r = valsNew())
-   || !(r->v = malloc(vals->n * sizeof (*r->v)))) {
-    valsRefFre(r);
-    return (0);
-  }
-  for (r->n = i = 0; i < vals->n; ++i)
-    if ((*(vals->v + i))->nam != val->nam) {
-      for (j = 0; j < infs->n; ++j)
-        if (bsearch(*(vals->v + i)
-           ,(*(infs->v + j))->vals->v
-           ,(*(infs->v + j))->vals->n
-           ,sizeof (*(*(infs->v + j))->vals->v)
-           ,(int(*)(const void *, const void *))valsSchCmp))
-          break;
-      if (j < infs->n)
-        *(r->v + r->n++) = *(vals->v + i);
+  for (v->valn = i = 0; i < v->nams->n; ++i) {
+    *((unsigned int *)&(*(v->nams->v + i))->rnk) = i + 1;
+    for (j = 0; j < (*(v->nams->v + i))->vals->n; ++j) {
+      *((unsigned int *)&(*((*(v->nams->v + i))->vals->v + j))->id) = v->valn++;
+      *((unsigned int *)&(*((*(v->nams->v + i))->vals->v + j))->rnk) = v->valn;
+      *((unsigned int *)&(*((*(v->nams->v + i))->vals->v + j))->cst) = 1;
     }
-  return (r);
+  }
+  for (i = 0; i < v->infs->n; ++i) {
+    *((unsigned int *)&(*(v->infs->v + i))->id) = i;
+    if (!(*((bits_t **)&(*(v->infs->v + i))->vb) = bitsNew(v->valn)))
+      return (1);
+    for (j = 0; j < (*(v->infs->v + i))->vals->n; ++j)
+      bitsSet((*(v->infs->v + i))->vb, (*((*(v->infs->v + i))->vals->v + j))->id);
+  }
+  return (csvLvl(v));
 }
 
-static vals_t *
-valsSubVal(
-  const vals_t *vals
- ,const val_t *val
- ,const infs_t *infs
+/* the -e profile, rows of name,value[,weight] with the weights of a value summed */
+struct prf {
+  const struct csv *csv;
+  const char *fil;
+  const nam_t *nam;
+  val_t *val;
+  double w;
+  int skp; /* comment or unknown */
+};
+
+static int
+prfCb(
+  csvTp_t t
+ ,unsigned int r
+ ,unsigned int c
+ ,const csvSt_t *l
+ ,void *v
 ){
-  vals_t *r;
-  unsigned int i;
+#define V ((struct prf *)v)
+  const sym_t *sym;
+  nam_t k;
+  const nam_t **n;
+  unsigned char *d;
+  char *e;
   unsigned int j;
-  unsigned int k;
+  int i;
 
-  r = 0;
-  if (!vals || !val
-   || !(r = valsNew())
-   || !(r->v = malloc(vals->n * sizeof (*r->v)))) {
-    valsRefFre(r);
-    return (0);
-  }
-  for (r->n = j = i = 0; i < vals->n; ++i)
-    if (*(vals->v + i) != val) {
-      for (k = 0; k < infs->n; ++k)
-        if (bsearch(*(vals->v + i)
-           ,(*(infs->v + k))->vals->v
-           ,(*(infs->v + k))->vals->n
-           ,sizeof (*(*(infs->v + k))->vals->v)
-           ,(int(*)(const void *, const void *))valsSchCmp))
-          break;
-      if (k < infs->n) {
-        *(r->v + r->n++) = *(vals->v + i);
-        if ((*(vals->v + i))->nam == val->nam)
-          ++j;
+  ++r;
+  switch (t) {
+  case csvTp_Cb:
+    V->nam = 0;
+    V->val = 0;
+    V->w = 1;
+    V->skp = 0;
+    break;
+  case csvTp_Ce:
+    if (!V->skp && V->val)
+      V->val->p += V->w;
+    else if (!V->skp && V->nam) {
+      fprintf(stderr, "profile has no value @%s:%u\n", V->fil, r);
+      return (1);
+    }
+    break;
+  case csvTp_Cv:
+    if (V->skp || !l->l)
+      break;
+    if (!c && *l->s == '#') {
+      V->skp = 1;
+      break;
+    }
+    if (c > 2) {
+      fprintf(stderr, "excess profile CSValue @%s:%u:%u(%.*s)\n", V->fil, r, c, l->l, l->s);
+      return (1);
+    }
+    if (!(d = malloc(l->l + 1))
+     || (i = csvDecodeValue(d, l->l, l->s, l->l)) < 0
+     || i > (int)l->l) {
+      free(d);
+      fprintf(stderr, "csvDecodeValue @%s:%u:%u(%.*s)\n", V->fil, r, c, l->l, l->s);
+      return (1);
+    }
+    if (c == 2) {
+      *(d + i) = '\0';
+      V->w = strtod((char *)d, &e);
+      /* not NaN or inf, they make no probabilities */
+      if (!i || *e || !(V->w >= 0 && V->w <= DBL_MAX)) {
+        fprintf(stderr, "bad profile weight @%s:%u:%u(%.*s)\n", V->fil, r, c, l->l, l->s);
+        free(d);
+        return (1);
       }
+      free(d);
+      break;
     }
-  if (j == 1) {
-    /* filter r in place instead of rebuilding with valsSubValNam */
-    for (j = i = 0; i < r->n; ++i)
-      if ((*(r->v + i))->nam != val->nam)
-        *(r->v + j++) = *(r->v + i);
-    r->n = j;
+    if (!(sym = symNew(d, i))) {
+      free(d);
+      fprintf(stderr, "symNew fail @%s:%u:%u(%.*s)\n", V->fil, r, c, l->l, l->s);
+      return (1);
+    }
+    free(d);
+    if (!c) {
+      k.sym = sym;
+      k.rnk = 0;
+      if ((n = bsearch(&k, V->csv->nams->v, V->csv->nams->n, sizeof (*V->csv->nams->v), (int(*)(const void *, const void *))namsSchCmp)))
+        V->nam = *n;
+    } else if (V->nam)
+      for (j = 0; j < V->nam->vals->n; ++j)
+        if (!symCmp((*(V->nam->vals->v + j))->sym, sym))
+          V->val = (val_t *)*(V->nam->vals->v + j);
+    if (!V->nam || (c && !V->val)) {
+      fprintf(stderr, "profile %s %.*s not in the tables, ignored @%s:%u:%u\n", c ? "value" : "name", sym->n, sym->v, V->fil, r, c);
+      V->skp = 1;
+    }
+    symFre(sym);
+    break;
   }
-  return (r);
+  return (0);
+#undef V
 }
 
-/* infs resolved by this val and not transitivly dependent on the remaining vals */
-static infs_t *
-infsResVal(
-  const vals_t *vals
- ,const infs_t *infs
- ,const val_t *val
+/* parse the side file fil (-e, -w) with cb */
+static int
+sidLod(
+  const char *prg
+ ,const char *fil
+ ,int (*cb)(csvTp_t, unsigned int, unsigned int, const csvSt_t *, void *)
+ ,void *v
 ){
-  infs_t *r;
-  unsigned int i;
-  unsigned int j;
-  unsigned int k;
-  unsigned int m;
-  unsigned int n;
-  int c;
+  struct stat st;
+  const unsigned char *bf;
+  int fd;
+  int r;
 
-  if (!(r = infsNew())
-   || !(r->v = malloc((infs->n < val->infs->n ? infs->n : val->infs->n) * sizeof (*r->v))))
-    return (0);
-  i = j = 0;
-  while (i < infs->n && j < val->infs->n) {
-    c = infCmp(*(infs->v + i), *(val->infs->v + j));
-    if (c < 0)
-      ++i;
-    else if (c > 0)
-      ++j;
-    else {
-      for (k = 0; k < (*(infs->v + i))->vals->n; ++k)
-        if (*((*(infs->v + i))->vals->v + k) != val) {
-          if (bsearch(*((*(infs->v + i))->vals->v + k)
-              ,vals->v
-              ,vals->n
-              ,sizeof (*vals->v)
-              ,(int(*)(const void *, const void *))valsSchCmp
-              )
-          )
-            break;
-          for (m = 0; m < infs->n; ++m) {
-            if (*((*(infs->v + i))->vals->v + k) != (*(infs->v + m))->val)
-              continue;
-            for (n = 0; n < (*(infs->v + m))->vals->n; ++n) {
-              if (bsearch(*((*(infs->v + m))->vals->v + n)
-                  ,vals->v
-                  ,vals->n
-                  ,sizeof (*vals->v)
-                  ,(int(*)(const void *, const void *))valsSchCmp
-                  )
-              )
-                break;
-            }
-            if (n < (*(infs->v + m))->vals->n)
-              break;
-          }
-          if (m < infs->n)
-            break;
-        }
-      if (k == (*(infs->v + i))->vals->n)
-        *(r->v + r->n++) = *(infs->v + i);
-      ++i;
-      ++j;
-    }
+  if ((fd = open(fil, O_RDONLY)) < 0) {
+    fprintf(stderr, "%s: Can't open %s\n", prg, fil);
+    return (1);
   }
+  if (fstat(fd, &st) || st.st_size > INT_MAX
+   || (bf = st.st_size ? mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : (const unsigned char *)"") == MAP_FAILED) {
+    fprintf(stderr, "%s: data fail on %s\n", prg, fil);
+    close(fd);
+    return (1);
+  }
+  close(fd);
+  if ((r = csvParse(cb, bf, st.st_size, v) != st.st_size))
+    fprintf(stderr, "%s: CSV parse fail on %s\n", prg, fil);
+  if (st.st_size)
+    munmap((void *)bf, st.st_size);
   return (r);
 }
 
-/* infs resolved by this val's nam's vals and not transitivly dependent on the remaining vals */
-static infs_t *
-infsResValNam(
-  const vals_t *vals
- ,const infs_t *infs
- ,const val_t *val
+/* set the val p of the nams in v by the profile fil, a nam without one is uniform */
+static int
+prfLod(
+  const struct csv *v
+ ,const char *prg
+ ,const char *fil
 ){
-  infs_t *r;
-  infs_t *t;
+  struct prf f;
+  double w;
   unsigned int i;
+  unsigned int j;
+  int r;
 
-  r = 0;
-  for (i = 0; i < val->nam->vals->n; ++i) {
-    if (*(val->nam->vals->v + i) == val)
-      continue;
-    if (!bsearch(*(val->nam->vals->v + i)
-        ,vals->v
-        ,vals->n
-        ,sizeof (*vals->v)
-        ,(int(*)(const void *, const void *))valsSchCmp))
-      continue;
-    t = infsResVal(vals, r ? r : infs, *(val->nam->vals->v + i));
-    infsRefFre(r);
-    if (!t)
-      return (t);
-    r = t;
+  memset(&f, 0, sizeof (f));
+  f.csv = v;
+  f.fil = fil;
+  r = sidLod(prg, fil, prfCb, &f);
+  for (i = 0; i < v->nams->n; ++i) {
+    for (w = 0, j = 0; j < (*(v->nams->v + i))->vals->n; ++j)
+      w += (*((*(v->nams->v + i))->vals->v + j))->p;
+    if (!(w <= DBL_MAX)) {
+      fprintf(stderr, "%s: profile weights of %.*s overflow on %s\n", prg, (*(v->nams->v + i))->sym->n, (*(v->nams->v + i))->sym->v, fil);
+      r = 1;
+      w = 0;
+    }
+    for (j = 0; j < (*(v->nams->v + i))->vals->n; ++j)
+      ((val_t *)*((*(v->nams->v + i))->vals->v + j))->p = w > 0
+        ? (*((*(v->nams->v + i))->vals->v + j))->p / w
+        : 1.0 / (*(v->nams->v + i))->vals->n;
   }
-  if (r)
-    return (r);
-  else
-    return (infsNew());
+  return (r);
 }
 
-/* Minus */
-static infs_t *
-infsMnsInfs(
-  const infs_t *infs1
- ,const infs_t *infs2
+/* the -w costs, rows of name,cost */
+#define CST_MAX 1000000
+struct cst {
+  const struct csv *csv;
+  const char *fil;
+  const nam_t *nam;
+  unsigned int c;
+  int skp; /* comment or unknown */
+};
+
+static int
+cstCb(
+  csvTp_t t
+ ,unsigned int r
+ ,unsigned int c
+ ,const csvSt_t *l
+ ,void *v
 ){
-  infs_t *r;
-  unsigned int i;
+#define V ((struct cst *)v)
+  const sym_t *sym;
+  nam_t k;
+  const nam_t **n;
+  unsigned char *d;
+  char *e;
+  unsigned long u;
   unsigned int j;
-  int c;
+  int i;
 
-  if (!(r = infsNew())
-   || !(r->v = malloc(infs1->n * sizeof (*r->v))))
-    return (0);
-  i = j = 0;
-  while (i < infs1->n && j < infs2->n) {
-    c = infCmp(*(infs1->v + i), *(infs2->v + j));
-    if (c < 0) {
-      *(r->v + r->n++) = *(infs1->v + i);
-      ++i;
-    } else if (c > 0) {
-      ++j;
-    } else {
-      ++i;
-      ++j;
+  ++r;
+  switch (t) {
+  case csvTp_Cb:
+    V->nam = 0;
+    V->c = 0;
+    V->skp = 0;
+    break;
+  case csvTp_Ce:
+    if (V->skp || !V->nam)
+      break;
+    if (!V->c) {
+      fprintf(stderr, "cost has no cost @%s:%u\n", V->fil, r);
+      return (1);
+    }
+    for (j = 0; j < V->nam->vals->n; ++j)
+      ((val_t *)*(V->nam->vals->v + j))->cst = V->c;
+    break;
+  case csvTp_Cv:
+    if (V->skp || !l->l)
+      break;
+    if (!c && *l->s == '#') {
+      V->skp = 1;
+      break;
+    }
+    if (c > 1) {
+      fprintf(stderr, "excess cost CSValue @%s:%u:%u(%.*s)\n", V->fil, r, c, l->l, l->s);
+      return (1);
+    }
+    if (!(d = malloc(l->l + 1))
+     || (i = csvDecodeValue(d, l->l, l->s, l->l)) < 0
+     || i > (int)l->l) {
+      free(d);
+      fprintf(stderr, "csvDecodeValue @%s:%u:%u(%.*s)\n", V->fil, r, c, l->l, l->s);
+      return (1);
+    }
+    if (c) {
+      *(d + i) = '\0';
+      u = strtoul((char *)d, &e, 10);
+      if (!i || *e || *d == '-')
+        u = 0;
+      free(d);
+      if (!u || u > CST_MAX) {
+        fprintf(stderr, "bad cost (1..%u) @%s:%u:%u(%.*s)\n", CST_MAX, V->fil, r, c, l->l, l->s);
+        return (1);
+      }
+      V->c = u;
+      break;
     }
+    if (!(sym = symNew(d, i))) {
+      free(d);
+      fprintf(stderr, "symNew fail @%s:%u:%u(%.*s)\n", V->fil, r, c, l->l, l->s);
+      return (1);
+    }
+    free(d);
+    k.sym = sym;
+    k.rnk = 0;
+    if ((n = bsearch(&k, V->csv->nams->v, V->csv->nams->n, sizeof (*V->csv->nams->v), (int(*)(const void *, const void *))namsSchCmp)))
+      V->nam = *n;
+    else {
+      fprintf(stderr, "cost name %.*s not in the tables, ignored @%s:%u:%u\n", sym->n, sym->v, V->fil, r, c);
+      V->skp = 1;
+    }
+    symFre(sym);
+    break;
   }
-  for (; i < infs1->n; ++i)
-    *(r->v + r->n++) = *(infs1->v + i);
-  return (r);
+  return (0);
+#undef V
 }
 
-/* Strip inf with same val or other vals */
-static infs_t *
-infsSrpInfs(
-  const infs_t *infs1
- ,const infs_t *infs2
+/* set the val cst of the nams in v by the costs fil, *w if one is not 1 */
+static int
+cstLod(
+  const struct csv *v
+ ,const char *prg
+ ,const char *fil
+ ,unsigned int *w
 ){
-  infs_t *r;
+  struct cst f;
+  unsigned long s;
   unsigned int i;
   unsigned int j;
-  unsigned int k;
+  int r;
 
-  if (!(r = infsNew())
-   || !(r->v = malloc(infs1->n * sizeof (*r->v))))
-    return (0);
-  for (i = 0; i < infs1->n; ++i) {
-    if (bsearch((*(infs1->v + i))->val
-        ,infs2->v
-        ,infs2->n
-        ,sizeof (*infs2->v)
-        ,(int(*)(const void *, const void *))infsValSchCmp
-        )
-    )
-      continue;
-    for (j = 0; j < (*(infs1->v + i))->vals->n; ++j) {
-      for (k = 0; k < infs2->n; ++k) {
-        if (*((*(infs1->v + i))->vals->v + j) != (*(infs2->v + k))->val
-         && (*((*(infs1->v + i))->vals->v + j))->nam == (*(infs2->v + k))->val->nam)
-          break;
-      }
-      if (k < infs2->n)
-        break;
+  memset(&f, 0, sizeof (f));
+  f.csv = v;
+  f.fil = fil;
+  r = sidLod(prg, fil, cstCb, &f);
+  for (s = 0, *w = 0, i = 0; i < v->nams->n; ++i)
+    for (j = 0; j < (*(v->nams->v + i))->vals->n; ++j) {
+      s += (*((*(v->nams->v + i))->vals->v + j))->cst;
+      if ((*((*(v->nams->v + i))->vals->v + j))->cst != 1)
+        *w = 1;
     }
-    if (j == (*(infs1->v + i))->vals->n)
-      *(r->v + r->n++) = *(infs1->v + i);
+  /* d is of a path, at most the sum */
+  if (!r && s > UINT_MAX / 2) {
+    fprintf(stderr, "%s: costs sum over %u on %s\n", prg, UINT_MAX / 2, fil);
+    r = 1;
   }
   return (r);
 }
 
-/********************************************************************************/
-
-typedef struct nod nod_t;
-
-struct nod {
-  const val_t *val;
-  infs_t *infsV;
-  infs_t *infsO;
-  const nod_t *nodV;
-  const nod_t *nodO;
-  unsigned int d;
-  unsigned int lbl;
-};
-
-static nod_t *
-nodNew(
-  void
-){
-  return (calloc(1, sizeof (nod_t)));
-}
-
-#if DTC_DEBUG
+#if 0 /* original, encoded on every output (and n truncated to a char) */
 static void
-nodPrt(
-  const nod_t *nod
+csvPrt(
+  const unsigned char *v
+ ,unsigned char n
 ){
-  if (!nod)
-    return;
-  printf("nod %d (\n", nod->d);
-  valPrt(nod->val);
-  infsPrt(nod->infsV);
-  infsPrt(nod->infsO);
-  nodPrt(nod->nodV);
-  nodPrt(nod->nodO);
-  puts(")");
+  unsigned char *e;
+  int l;
+
+  if (!(e = malloc(n * 2))
+   || (l = csvEncodeValue(e, n * 2, v, n)) <= 0)
+    printf("%.*s", (int)n, v);
+  else
+    printf("%.*s", l, e);
+  free(e);
 }
+#endif
+
+/********************************************************************************/
 
+/* val is known, b2 gets the vals of its nam */
 static void
-nodNstPrt(
-  const nod_t *nod
- ,unsigned int d
+infsValTrnKnw(
+  bits_t *b1
+ ,bits_t *b2
+ ,const val_t *val
 ){
   unsigned int i;
-  unsigned int s;
 
-  if (!nod)
-    return;
-  for (s = 0; s < d; ++s)putchar(' '),putchar(' ');
-  if (nod->val)
-    printf("{ %.*s %.*s\n", nod->val->nam->sym->n, nod->val->nam->sym->v, nod->val->sym->n, nod->val->sym->v);
-  else
-    puts("{ !val");
-  if (nod->infsV) for (i = 0; i < nod->infsV->n; ++i) {
-    for (s = 0; s < d; ++s)putchar(' '),putchar(' '),putchar(' '),putchar(' ');
-    printf("= %.*s %.*s\n", (*(nod->infsV->v + i))->val->nam->sym->n, (*(nod->infsV->v + i))->val->nam->sym->v, (*(nod->infsV->v + i))->val->sym->n, (*(nod->infsV->v + i))->val->sym->v);
-  }
-  nodNstPrt(nod->nodV, d + 1);
-  for (s = 0; s < d; ++s)putchar(' '),putchar(' ');
-  puts("}{");
-  if (nod->infsO) for (i = 0; i < nod->infsO->n; ++i) {
-    for (s = 0; s < d; ++s)putchar(' '),putchar(' '),putchar(' '),putchar(' ');
-    printf("= %.*s %.*s\n", (*(nod->infsO->v + i))->val->nam->sym->n, (*(nod->infsO->v + i))->val->nam->sym->v, (*(nod->infsO->v + i))->val->sym->n, (*(nod->infsO->v + i))->val->sym->v);
-  }
-  nodNstPrt(nod->nodO, d + 1);
-  for (s = 0; s < d; ++s)putchar(' '),putchar(' ');
-  puts("}");
+  bitsSet(b1, val->id);
+  for (i = 0; i < val->nam->vals->n; ++i)
+    bitsSet(b2, (*(val->nam->vals->v + i))->id);
 }
 
-static void
-nodValsPrt(
-  const vals_t *vals
+/* transitive closure, r (a subset of infs) has room for all of infs */
+/* the infs are taken by their lvl so one pass reaches the fixed point, */
+/* which is only iterated to when there is a cycle */
+static int
+infsValTrnAdd(
+  are_t *are
+ ,const val_t *val
+ ,const infs_t *infs
+ ,const bits_t *vb
+ ,infs_t *r
 ){
+  const inf_t *inf;
+  bits_t *b1;
+  bits_t *b2;
+  bits_t *b3;
+  const val_t *d;
+  areMrk_t m;
+  unsigned int l;
+  unsigned int x;
+  unsigned int n;
+  unsigned int k;
   unsigned int i;
   unsigned int j;
 
-  if (!vals)
-    return;
-  for (i = 0; i < vals->n; ++i) {
-    printf(" %.*s %.*s\n"
-    ,(*(vals->v + i))->nam->sym->n
-    ,(*(vals->v + i))->nam->sym->v
-    ,(*(vals->v + i))->sym->n
-    ,(*(vals->v + i))->sym->v
-    );
-    for (j = 0; j < (*(vals->v + i))->infs->n; ++j)
-      printf("  = %.*s %.*s\n"
-      ,(*((*(vals->v + i))->infs->v + j))->val->nam->sym->n
-      ,(*((*(vals->v + i))->infs->v + j))->val->nam->sym->v
-      ,(*((*(vals->v + i))->infs->v + j))->val->sym->n
-      ,(*((*(vals->v + i))->infs->v + j))->val->sym->v
-      );
+  m = areMrk(are);
+  /* b1 the known vals, b2 the vals of their nams, b3 the vals of the nams infs infer */
+  if (!(b1 = bitsAre(are, vb->n * BITS_W))
+   || !(b2 = bitsAre(are, vb->n * BITS_W))
+   || !(b3 = bitsAre(are, vb->n * BITS_W)))
+    return (1);
+  infsValTrnKnw(b1, b2, val);
+  for (i = 0; i < r->n; ++i)
+    infsValTrnKnw(b1, b2, (*(r->v + i))->val);
+  for (x = i = 0; i < infs->n; ++i) {
+    inf = *(infs->v + i);
+    if (!bitsTst(b3, inf->val->id))
+      for (j = 0; j < inf->val->nam->vals->n; ++j)
+        bitsSet(b3, (*(inf->val->nam->vals->v + j))->id);
+    if (inf->lvl > x)
+      x = inf->lvl;
+  }
+  for (k = 0, l = 1;;) {
+    n = k;
+    for (i = 0; i < infs->n; ++i) {
+      inf = *(infs->v + i);
+      if (x != ~0U && inf->lvl != l)
+        continue;
+      for (j = 0; j < inf->vals->n; ++j) {
+        d = *(inf->vals->v + j);
+        if (!bitsTst(b1, d->id)
+         && (bitsTst(b2, d->id) || bitsTst(vb, d->id) || bitsTst(b3, d->id)))
+          break;
+      }
+      if (j < inf->vals->n)
+        continue;
+      infsIns(r, inf);
+      if (!bitsTst(b1, inf->val->id)) {
+        infsValTrnKnw(b1, b2, inf->val);
+        ++k;
+      }
+    }
+    if (x == ~0U ? k == n : ++l > x)
+      break;
   }
+  areRst(are, m);
+  return (0);
 }
 
-static void
-nodInfsPrt(
-  const infs_t *infs
+#if 0 /* original fixed point, rescanning infs for the nams */
+/* transitive closure, r (a subset of infs) has room for all of infs */
+static int
+infsValTrnAdd(
+  are_t *are
+ ,const val_t *val
+ ,const infs_t *infs
+ ,const bits_t *vb
+ ,infs_t *r
 ){
+  vals_t *v1;
+  bits_t *b1;
+  const val_t *d;
+  areMrk_t m;
+  unsigned int n;
   unsigned int i;
   unsigned int j;
+  unsigned int k;
 
-  if (!infs)
-    return;
-  for (i = 0; i < infs->n; ++i) {
-    printf(" = %.*s %.*s"
-    ,(*(infs->v + i))->val->nam->sym->n
-    ,(*(infs->v + i))->val->nam->sym->v
-    ,(*(infs->v + i))->val->sym->n
-    ,(*(infs->v + i))->val->sym->v
-    );
-    for (j = 0; j < (*(infs->v + i))->vals->n; ++j)
-      printf(" : %.*s %.*s"
-      ,(*((*(infs->v + i))->vals->v + j))->nam->sym->n
-      ,(*((*(infs->v + i))->vals->v + j))->nam->sym->v
-      ,(*((*(infs->v + i))->vals->v + j))->sym->n
-      ,(*((*(infs->v + i))->vals->v + j))->sym->v
-      );
-    putchar('\n');
+  m = areMrk(are);
+  if (!(v1 = valsAre(are, 1 + infs->n))
+   || !(b1 = bitsAre(are, vb->n * BITS_W)))
+    return (1);
+  /* v1 is the vals of b1, unordered */
+  *(v1->v + v1->n++) = val;
+  bitsSet(b1, val->id);
+  for (i = 0; i < r->n; ++i)
+    if (!bitsTst(b1, (*(r->v + i))->val->id)) {
+      *(v1->v + v1->n++) = (*(r->v + i))->val;
+      bitsSet(b1, (*(r->v + i))->val->id);
+    }
+  for (;;) {
+    n = v1->n;
+    for (i = 0; i < infs->n; ++i) {
+      for (j = 0; j < (*(infs->v + i))->vals->n; ++j) {
+        d = *((*(infs->v + i))->vals->v + j);
+        if (bitsTst(b1, d->id))
+          continue;
+        for (k = 0; k < v1->n; ++k)
+          if ((*(v1->v + k))->nam == d->nam)
+            goto continue_i;
+        if (bitsTst(vb, d->id))
+          goto continue_i;
+        for (k = 0; k < infs->n; ++k)
+          if ((*(infs->v + k))->val->nam == d->nam)
+            break;
+        if (k < infs->n)
+          goto continue_i;
+      }
+      infsIns(r, *(infs->v + i));
+      if (!bitsTst(b1, (*(infs->v + i))->val->id)) {
+        *(v1->v + v1->n++) = (*(infs->v + i))->val;
+        bitsSet(b1, (*(infs->v + i))->val->id);
+      }
+continue_i:;
+    }
+    if (v1->n == n)
+      break;
   }
+  areRst(are, m);
+  return (0);
 }
 #endif
 
 static int
-infsChk(
-  const infs_t *infs
- ,const char *prg
+infsVal(
+  const val_t *val
+ ,const infs_t *infs
+ ,infs_t *r
 ){
-  unsigned int i;
   unsigned int j;
-  int r;
 
-  r = 0;
-  if (!infs)
-    return (r);
-  for (i = 0; i < infs->n; ++i)
-    for (j = i + 1; j < infs->n; ++j)
-      if ((*(infs->v + i))->val->nam == (*(infs->v + j))->val->nam
-       && (*(infs->v + i))->val != (*(infs->v + j))->val) {
-        fprintf(stderr, "%s: unresolvable \"%.*s\": \"%.*s\" @%s:%u vs \"%.*s\" @%s:%u\n"
-        ,prg
-        ,(*(infs->v + i))->val->nam->sym->n
-        ,(*(infs->v + i))->val->nam->sym->v
-        ,(*(infs->v + i))->val->sym->n
-        ,(*(infs->v + i))->val->sym->v
-        ,(*(infs->v + i))->fil
-        ,(*(infs->v + i))->row
-        ,(*(infs->v + j))->val->sym->n
-        ,(*(infs->v + j))->val->sym->v
-        ,(*(infs->v + j))->fil
-        ,(*(infs->v + j))->row
-        );
-        r = 1;
-      }
-  return (r);
+  for (j = 0; j < infs->n; ++j)
+    if (bitsTst((*(infs->v + j))->vb, val->id)
+     && !infsAdd(r, *(infs->v + j))) {
+      infsRefFre(r);
+      return (1);
+    }
+  return (0);
 }
 
-static int
-nodChk(
-  const nod_t *nod
- ,const char *prg
+/* independent values */
+static vals_t *
+namsInd(
+  const nams_t *nams
+ ,const infs_t *infs
 ){
-  int r;
+  vals_t *r;
+  unsigned int i;
+  unsigned int j;
 
-  r = 0;
-  if (!nod)
-    return (r);
-  r |= infsChk(nod->infsV, prg);
-  r |= infsChk(nod->infsO, prg);
-  r |= nodChk(nod->nodV, prg);
-  r |= nodChk(nod->nodO, prg);
+  if (!(r = valsNew()))
+    return (0);
+  for (i = 0; i < nams->n; ++i)
+    for (j = 0; j < (*(nams->v + i))->vals->n; ++j) {
+      if (!bsearch(*((*(nams->v + i))->vals->v + j)
+          ,infs->v
+          ,infs->n
+          ,sizeof (*infs->v)
+          ,(int(*)(const void *, const void *))infsValSchCmp
+          )
+       && valsAdd(r, *((*(nams->v + i))->vals->v + j)) != *((*(nams->v + i))->vals->v + j)) {
+          valsRefFre(r);
+          return (0);
+      }
+    }
+  for (i = 0; i < r->n; ++i) {
+    if (!(*((infs_t **)&(*(r->v + i))->infs) = infsNew())
+     || infsVal(*(r->v + i), infs, (*(r->v + i))->infs)
+     || !(*((bits_t **)&(*(r->v + i))->ib) = bitsNew(infs->n))) {
+      valsRefFre(r);
+      return (0);
+    }
+    for (j = 0; j < (*(r->v + i))->infs->n; ++j)
+      bitsSet((*(r->v + i))->ib, (*((*(r->v + i))->infs->v + j))->id);
+  }
+  for (i = 0; i < r->n; ++i) {
+    const nam_t *nam;
+    unsigned int k;
+
+    if (!(*((bits_t **)&(*(r->v + i))->ob) = bitsNew(infs->n))) {
+      valsRefFre(r);
+      return (0);
+    }
+    nam = (*(r->v + i))->nam;
+    for (k = 0; k < nam->vals->n; ++k)
+      if (*(nam->vals->v + k) != *(r->v + i) && (*(nam->vals->v + k))->ib)
+        bitsOr((*(r->v + i))->ob, (*(nam->vals->v + k))->ib);
+  }
+  /* sum of "other" infs */
+  for (i = 0; i < r->n; ++i) {
+    const val_t *val;
+    unsigned int o;
+    unsigned int k;
+
+    val = *(r->v + i);
+    for (o = k = 0; k < val->nam->vals->n; ++k)
+      if (*(val->nam->vals->v + k) != val && (*(val->nam->vals->v + k))->infs)
+        o += (*(val->nam->vals->v + k))->infs->n;
+    *((unsigned int *)&val->bal) = val->infs->n > o ? val->infs->n - o : o - val->infs->n;
+    *((unsigned int *)&val->dly) = val->infs->n > o ? o : val->infs->n;
+  }
+  for (i = 0; i < infs->n; ++i) {
+    for (j = 0; j < (*(infs->v + i))->vals->n; ++j)
+      if (!(*((*(infs->v + i))->vals->v + j))->ib)
+        break;
+    *((unsigned int *)&(*(infs->v + i))->ind) = j == (*(infs->v + i))->vals->n;
+  }
   return (r);
 }
 
-static void
-nodFre(
-  nod_t *nod
+/* an inf of a val by the hash without the val, for valsEq */
+typedef struct {
+  const inf_t *inf;
+  unsigned long h;
+} valsEqK_t;
+
+static int
+valsEqKCmp(
+  const valsEqK_t *e1
+ ,const valsEqK_t *e2
 ){
-  if (!nod)
-    return;
-  infsRefFre(nod->infsV);
-  infsRefFre(nod->infsO);
-  free(nod);
+  if (e1->h != e2->h)
+    return (e1->h < e2->h ? -1 : 1);
+  if (e1->inf->id != e2->inf->id)
+    return (e1->inf->id < e2->inf->id ? -1 : 1);
+  return (0);
 }
 
-/********************************************************************************/
-
-typedef struct bld bld_t;
+/* inf1 with val1 in place of val2 is inf2 */
+static int
+valsEqInf(
+  const inf_t *inf1
+ ,const val_t *val1
+ ,const inf_t *inf2
+ ,const val_t *val2
+){
+  unsigned int i;
 
-struct bld {
-  vals_t *vals;
-  infs_t *infs;
-  nod_t *nod;
-};
+  if (inf1->val != inf2->val
+   || inf1->vals->n != inf2->vals->n)
+    return (0);
+  for (i = 0; i < inf1->vals->n; ++i)
+    if (*(inf1->vals->v + i) != *(inf2->vals->v + i)
+     && (*(inf1->vals->v + i) != val1 || *(inf2->vals->v + i) != val2))
+      return (0);
+  return (1);
+}
 
-static bld_t *
-bldNew(
+/*
+ * Interchangeable independent vals (from namsInd, all the vals of their nams):
+ * two vals of a nam are when swapping them maps the infs (and p) onto
+ * themselves. Where both are left to test, testing one builds the mirror of
+ * what testing the other does, so nodBld tries only the first (valsEqPrv).
+ * eq is set to the first val of each class, returns the number of the others
+ * or ~0U on alloc fail.
+ */
+static unsigned int
+valsEq(
   const vals_t *vals
- ,const infs_t *infs
 ){
-  bld_t *r;
+  const nam_t *nam;
+  const val_t *u;
+  const val_t *v;
+  valsEqK_t *k;
+  unsigned int *o;
+  unsigned int n;
+  unsigned int r;
+  unsigned int i;
+  unsigned int j;
+  unsigned int l;
+  unsigned int m;
 
-  if (!vals || !infs
-   || !(r = calloc(1, sizeof (*r))))
-    return (0);
-  if (!(r->vals = valsRefDup(vals))
-   || !(r->infs = infsRefDup(infs))) {
-    valsRefFre(r->vals);
-    free(r);
-    return (0);
+  for (r = i = 0, nam = 0; i < vals->n; ++i) {
+    if ((*(vals->v + i))->nam == nam)
+      continue;
+    nam = (*(vals->v + i))->nam;
+    if (nam->vals->n < 2)
+      continue;
+    /* the infs of each val, sorted by their hash without it, from o */
+    if (!(o = malloc((nam->vals->n + 1) * sizeof (*o))))
+      return (~0U);
+    for (*o = n = j = 0; j < nam->vals->n; ++j)
+      *(o + j + 1) = n += (*(nam->vals->v + j))->infs->n;
+    if (!(k = malloc((n ? n : 1) * sizeof (*k)))) {
+      free(o);
+      return (~0U);
+    }
+    for (j = 0; j < nam->vals->n; ++j) {
+      v = *(nam->vals->v + j);
+      for (l = 0; l < v->infs->n; ++l) {
+        const inf_t *inf;
+        unsigned long h;
+
+        inf = *(v->infs->v + l);
+        h = 2166136261UL;
+        h = (h ^ inf->val->id) * 16777619UL;
+        for (m = 0; m < inf->vals->n; ++m)
+          if ((*(inf->vals->v + m))->nam != nam)
+            h = (h ^ (*(inf->vals->v + m))->id) * 16777619UL;
+        (k + *(o + j) + l)->inf = inf;
+        (k + *(o + j) + l)->h = h ^ h >> 15;
+      }
+      qsort(k + *(o + j), v->infs->n, sizeof (*k), (int(*)(const void *, const void *))valsEqKCmp);
+    }
+    /* each val against the first of the classes before it */
+    for (j = 1; j < nam->vals->n; ++j) {
+      v = *(nam->vals->v + j);
+      for (l = 0; l < j; ++l) {
+        u = *(nam->vals->v + l);
+        if ((u->eq && u->eq != u)
+         || u->infs->n != v->infs->n
+         || u->p != v->p)
+          continue;
+        for (m = 0; m < u->infs->n
+         && (k + *(o + l) + m)->h == (k + *(o + j) + m)->h
+         && valsEqInf((k + *(o + l) + m)->inf, u, (k + *(o + j) + m)->inf, v); ++m);
+        if (m == u->infs->n) {
+          *((const val_t **)&u->eq) = u;
+          *((const val_t **)&v->eq) = u;
+          ++r;
+          break;
+        }
+      }
+    }
+    free(k);
+    free(o);
   }
   return (r);
 }
 
-#if DTC_DEBUG
-static void
-bldPrt(
-  const bld_t *bld
+/* an earlier candidate of vs is interchangeable with candidate i (valsEq) */
+static int
+valsEqPrv(
+  const vals_t *vs
+ ,unsigned int i
 ){
-  if (!bld)
-    return;
-  valsPrt(bld->vals);
-  infsPrt(bld->infs);
-  nodPrt(bld->nod);
-}
-#endif
+  unsigned int j;
 
-static void
-bldFre(
-  bld_t *bld
-){
-  if (!bld)
-    return;
-  valsRefFre(bld->vals);
-  infsRefFre(bld->infs);
-  nodFre(bld->nod);
-  free(bld);
+  if (!(*(vs->v + i))->eq)
+    return (0);
+  for (j = 0; j < i; ++j)
+    if ((*(vs->v + j))->eq == (*(vs->v + i))->eq)
+      return (1);
+  return (0);
 }
 
+/*
+ * candidate i is the later of the only two vals of its nam left (in vb):
+ * testing either splits vals and infs the same way with V and O swapped,
+ * and the earlier one is kept on a tie, so only the earlier one is built
+ */
 static int
-bldCmp(
-  const bld_t *e1
- ,const bld_t *e2
+valsTwoPrv(
+  const vals_t *vs
+ ,const bits_t *vb
+ ,unsigned int i
 ){
-  int r;
-
-  if ((r = valsCmp(e1->vals, e2->vals)))
-    return (r);
-  return (infsCmp(e1->infs, e2->infs));
-}
-
-/********************************************************************************/
-
-typedef struct blds blds_t;
-
-struct blds {
-  bld_t **v;
+  const nam_t *nam;
+  const val_t *o;
+  unsigned int j;
   unsigned int n;
-};
 
-static blds_t *
-bldsNew(
-  void
-){
-  return (calloc(1, sizeof (blds_t)));
+  nam = (*(vs->v + i))->nam;
+  for (o = 0, n = j = 0; j < nam->vals->n; ++j)
+    if (bitsTst(vb, (*(nam->vals->v + j))->id)) {
+      if (*(nam->vals->v + j) != *(vs->v + i))
+        o = *(nam->vals->v + j);
+      if (++n > 2)
+        return (0);
+    }
+  if (n != 2)
+    return (0);
+  for (j = 0; j < i; ++j)
+    if (*(vs->v + j) == o)
+      return (1);
+  return (0);
 }
 
-static int
-bldsSchCmp(
-  const bld_t *k
- ,const bld_t **e
+/* connected components of the nams by their infs, c by nam rnk - 1 (~0U for none) */
+/* numbered in the order of their first inf, returns the number or ~0U on alloc fail */
+static unsigned int
+namsSpl(
+  const nams_t *nams
+ ,const infs_t *infs
+ ,unsigned int *c
 ){
-  return (bldCmp(k, *e));
+  unsigned int *p;
+  unsigned int i;
+  unsigned int j;
+  unsigned int a;
+  unsigned int b;
+  unsigned int n;
+
+  if (!(p = malloc((nams->n ? nams->n : 1) * sizeof (*p))))
+    return (~0U);
+  /* union find, p the parents, with path halving */
+  for (i = 0; i < nams->n; ++i)
+    *(p + i) = i;
+  for (i = 0; i < infs->n; ++i) {
+    for (a = (*(infs->v + i))->val->nam->rnk - 1; *(p + a) != a; a = *(p + a) = *(p + *(p + a)));
+    for (j = 0; j < (*(infs->v + i))->vals->n; ++j) {
+      for (b = (*((*(infs->v + i))->vals->v + j))->nam->rnk - 1; *(p + b) != b; b = *(p + b) = *(p + *(p + b)));
+      *(p + b) = a;
+    }
+  }
+  for (i = 0; i < nams->n; ++i)
+    *(c + i) = ~0U;
+  for (n = i = 0; i < infs->n; ++i) {
+    for (a = (*(infs->v + i))->val->nam->rnk - 1; *(p + a) != a; a = *(p + a));
+    if (*(c + a) == ~0U)
+      *(c + a) = n++;
+  }
+  for (i = 0; i < nams->n; ++i) {
+    for (a = i; *(p + a) != a; a = *(p + a));
+    *(c + i) = *(c + a);
+  }
+  free(p);
+  return (n);
 }
 
+/* keys from namsInd, the infs of vals do not change during a build */
 static int
-bldsSrtCmp(
-  const bld_t **e1
- ,const bld_t **e2
+valsInfsCmp(
+  const val_t **e1
+ ,const val_t **e2
 ){
-  return (bldCmp(*e1, *e2));
+  /* primary sort balance (smallest difference of number of inf_t) */
+  if ((*e1)->bal < (*e2)->bal)
+    return (-1);
+  if ((*e1)->bal > (*e2)->bal)
+    return (1);
+  /* secondary sort delay (largest smallest number of inf_t) */
+  if ((*e1)->dly > (*e2)->dly)
+    return (-1);
+  if ((*e1)->dly < (*e2)->dly)
+    return (1);
+  return (0);
 }
 
-static bld_t *
-bldsFnd(
-  blds_t *blds
+/* u is scratch for the union of the infs' vals */
+static vals_t *
+valsSubValNam(
+  are_t *are
  ,const vals_t *vals
+ ,const val_t *val
  ,const infs_t *infs
+ ,bits_t *u
 ){
-  bld_t **r;
-  bld_t k;
+  vals_t *r;
+  unsigned int i;
 
-  if (!blds || !vals || !infs)
+  if (!vals || !val
+   || !(r = valsAre(are, vals->n)))
     return (0);
-  k.vals = (vals_t *)vals;
-  k.infs = (infs_t *)infs;
-  if ((r = bsearch(&k, blds->v, blds->n, sizeof (*blds->v), (int(*)(const void *, const void *))bldsSchCmp)))
-    return (*r);
+  bitsClr(u);
+  for (i = 0; i < infs->n; ++i)
+    bitsOr(u, (*(infs->v + i))->vb);
+  for (r->n = i = 0; i < vals->n; ++i)
+    if ((*(vals->v + i))->nam != val->nam
+     && bitsTst(u, (*(vals->v + i))->id))
+      *(r->v + r->n++) = *(vals->v + i);
+  return (r);
+}
+
+/* u is scratch for the union of the infs' vals */
+static vals_t *
+valsSubVal(
+  are_t *are
+ ,const vals_t *vals
+ ,const val_t *val
+ ,const infs_t *infs
+ ,bits_t *u
+){
+  vals_t *r;
+  unsigned int i;
+  unsigned int j;
+
+  if (!vals || !val
+   || !(r = valsAre(are, vals->n)))
+    return (0);
+  bitsClr(u);
+  for (i = 0; i < infs->n; ++i)
+    bitsOr(u, (*(infs->v + i))->vb);
+  for (r->n = j = i = 0; i < vals->n; ++i)
+    if (*(vals->v + i) != val
+     && bitsTst(u, (*(vals->v + i))->id)) {
+      *(r->v + r->n++) = *(vals->v + i);
+      if ((*(vals->v + i))->nam == val->nam)
+        ++j;
+    }
+  if (j == 1) {
+    /* filter r in place instead of rebuilding with valsSubValNam */
+    for (j = i = 0; i < r->n; ++i)
+      if ((*(r->v + i))->nam != val->nam)
+        *(r->v + j++) = *(r->v + i);
+    r->n = j;
+  }
+  return (r);
+}
+
+/* infs resolved by this val and not transitivly dependent on the remaining vals */
+/* vb is the remaining vals, r has room for m */
+static infs_t *
+infsResVal(
+  are_t *are
+ ,const bits_t *vb
+ ,const infs_t *infs
+ ,const val_t *val
+ ,unsigned int m
+){
+  infs_t *r;
+  unsigned int i;
+  unsigned int j;
+  unsigned int k;
+
+  if (!(r = infsAre(are, m)))
+    return (0);
+  i = j = 0;
+  while (i < infs->n && j < val->infs->n) {
+    if ((*(infs->v + i))->id < (*(val->infs->v + j))->id)
+      ++i;
+    else if ((*(infs->v + i))->id > (*(val->infs->v + j))->id)
+      ++j;
+    else {
+      /* val is in both, any other remaining val depends */
+      if (bitsAndCnt((*(infs->v + i))->vb, vb) > 1)
+        k = 0;
+      else for (k = 0; k < (*(infs->v + i))->vals->n; ++k)
+        if (*((*(infs->v + i))->vals->v + k) != val) {
+          for (m = 0; m < infs->n; ++m)
+            if (*((*(infs->v + i))->vals->v + k) == (*(infs->v + m))->val
+             && bitsAnd((*(infs->v + m))->vb, vb))
+              break;
+          if (m < infs->n)
+            break;
+        }
+      if (k == (*(infs->v + i))->vals->n)
+        *(r->v + r->n++) = *(infs->v + i);
+      ++i;
+      ++j;
+    }
+  }
+  return (r);
+}
+
+/* infs resolved by this val's nam's vals and not transitivly dependent on the remaining vals */
+static infs_t *
+infsResValNam(
+  are_t *are
+ ,const bits_t *vb
+ ,const infs_t *infs
+ ,const val_t *val
+){
+  infs_t *r;
+  infs_t *t;
+  unsigned int i;
+
+  r = 0;
+  for (i = 0; i < val->nam->vals->n; ++i) {
+    if (*(val->nam->vals->v + i) == val)
+      continue;
+    if (!bitsTst(vb, (*(val->nam->vals->v + i))->id))
+      continue;
+    if (!(t = infsResVal(are, vb, r ? r : infs, *(val->nam->vals->v + i), infs->n)))
+      return (t);
+    r = t;
+  }
+  if (r)
+    return (r);
+  else
+    return (infsAre(are, infs->n));
+}
+
+/* Minus (bits of inf_t id) */
+static infs_t *
+infsMnsInfs(
+  are_t *are
+ ,const infs_t *infs1
+ ,const bits_t *infs2
+){
+  infs_t *r;
+  unsigned int i;
+
+  if (!(r = infsAre(are, infs1->n)))
+    return (0);
+  for (i = 0; i < infs1->n; ++i)
+    if (!bitsTst(infs2, (*(infs1->v + i))->id))
+      *(r->v + r->n++) = *(infs1->v + i);
+  return (r);
+}
+
+/* Strip inf with same val or other vals, rv and cv are scratch */
+static infs_t *
+infsSrpInfs(
+  are_t *are
+ ,const infs_t *infs1
+ ,const infs_t *infs2
+ ,bits_t *rv
+ ,bits_t *cv
+){
+  infs_t *r;
+  const val_t *v;
+  unsigned int i;
+  unsigned int j;
+
+  if (!(r = infsAre(are, infs1->n)))
+    return (0);
+  /* resolved vals and the other vals of their nams */
+  bitsClr(rv);
+  bitsClr(cv);
+  for (i = 0; i < infs2->n; ++i) {
+    v = (*(infs2->v + i))->val;
+    bitsSet(rv, v->id);
+    for (j = 0; j < v->nam->vals->n; ++j)
+      if (*(v->nam->vals->v + j) != v)
+        bitsSet(cv, (*(v->nam->vals->v + j))->id);
+  }
+  for (i = 0; i < infs1->n; ++i)
+    if (!bitsTst(rv, (*(infs1->v + i))->val->id)
+     && !bitsAnd((*(infs1->v + i))->vb, cv))
+      *(r->v + r->n++) = *(infs1->v + i);
+  return (r);
+}
+
+/********************************************************************************/
+
+typedef struct nod nod_t;
+
+struct nod {
+  const val_t *val;
+  infs_t *infsV;
+  infs_t *infsO;
+  const nod_t *nodV;
+  const nod_t *nodO;
+  unsigned int d;
+  unsigned int lbl;
+  double e; /* expected tests, by the val p */
+};
+
+/* copy of src in dst with the infs in are */
+static int
+nodCpy(
+  are_t *are
+ ,nod_t *dst
+ ,const nod_t *src
+){
+  *dst = *src;
+  if ((src->infsV && !(dst->infsV = infsAreDup(are, src->infsV)))
+   || (src->infsO && !(dst->infsO = infsAreDup(are, src->infsO))))
+    return (1);
+  return (0);
+}
+
+/* returned, not memoized, when the lower bound is over the cut */
+static nod_t nodCut;
+
+/* --memo-limit: move *n and the nod_t it refers to into are, the old ones forward */
+static int
+nodMov(
+  are_t *are
+ ,const nod_t **n
+){
+  nod_t *o;
+  nod_t *r;
+
+  if (!*n || *n == &nodCut)
+    return (0);
+  o = (nod_t *)*n;
+  if (o->lbl == ~0U) {
+    *n = o->nodV;
+    return (0);
+  }
+  if (!(r = areAlc(are, sizeof (*r)))
+   || nodCpy(are, r, o))
+    return (1);
+  o->lbl = ~0U;
+  o->nodV = r;
+  *n = r;
+  return (nodMov(are, &r->nodV) || nodMov(are, &r->nodO));
+}
+
+#if DTC_DEBUG
+static void
+nodPrt(
+  const nod_t *nod
+){
+  if (!nod)
+    return;
+  printf("nod %d (\n", nod->d);
+  valPrt(nod->val);
+  infsPrt(nod->infsV);
+  infsPrt(nod->infsO);
+  nodPrt(nod->nodV);
+  nodPrt(nod->nodO);
+  puts(")");
+}
+
+static void
+nodNstPrt(
+  const nod_t *nod
+ ,unsigned int d
+){
+  unsigned int i;
+  unsigned int s;
+
+  if (!nod)
+    return;
+  for (s = 0; s < d; ++s)putchar(' '),putchar(' ');
+  if (nod->val)
+    printf("{ %.*s %.*s\n", nod->val->nam->sym->n, nod->val->nam->sym->v, nod->val->sym->n, nod->val->sym->v);
+  else
+    puts("{ !val");
+  if (nod->infsV) for (i = 0; i < nod->infsV->n; ++i) {
+    for (s = 0; s < d; ++s)putchar(' '),putchar(' '),putchar(' '),putchar(' ');
+    printf("= %.*s %.*s\n", (*(nod->infsV->v + i))->val->nam->sym->n, (*(nod->infsV->v + i))->val->nam->sym->v, (*(nod->infsV->v + i))->val->sym->n, (*(nod->infsV->v + i))->val->sym->v);
+  }
+  nodNstPrt(nod->nodV, d + 1);
+  for (s = 0; s < d; ++s)putchar(' '),putchar(' ');
+  puts("}{");
+  if (nod->infsO) for (i = 0; i < nod->infsO->n; ++i) {
+    for (s = 0; s < d; ++s)putchar(' '),putchar(' '),putchar(' '),putchar(' ');
+    printf("= %.*s %.*s\n", (*(nod->infsO->v + i))->val->nam->sym->n, (*(nod->infsO->v + i))->val->nam->sym->v, (*(nod->infsO->v + i))->val->sym->n, (*(nod->infsO->v + i))->val->sym->v);
+  }
+  nodNstPrt(nod->nodO, d + 1);
+  for (s = 0; s < d; ++s)putchar(' '),putchar(' ');
+  puts("}");
+}
+
+static void
+nodValsPrt(
+  const vals_t *vals
+){
+  unsigned int i;
+  unsigned int j;
+
+  if (!vals)
+    return;
+  for (i = 0; i < vals->n; ++i) {
+    printf(" %.*s %.*s\n"
+    ,(*(vals->v + i))->nam->sym->n
+    ,(*(vals->v + i))->nam->sym->v
+    ,(*(vals->v + i))->sym->n
+    ,(*(vals->v + i))->sym->v
+    );
+    for (j = 0; j < (*(vals->v + i))->infs->n; ++j)
+      printf("  = %.*s %.*s\n"
+      ,(*((*(vals->v + i))->infs->v + j))->val->nam->sym->n
+      ,(*((*(vals->v + i))->infs->v + j))->val->nam->sym->v
+      ,(*((*(vals->v + i))->infs->v + j))->val->sym->n
+      ,(*((*(vals->v + i))->infs->v + j))->val->sym->v
+      );
+  }
+}
+
+static void
+nodInfsPrt(
+  const infs_t *infs
+){
+  unsigned int i;
+  unsigned int j;
+
+  if (!infs)
+    return;
+  for (i = 0; i < infs->n; ++i) {
+    printf(" = %.*s %.*s"
+    ,(*(infs->v + i))->val->nam->sym->n
+    ,(*(infs->v + i))->val->nam->sym->v
+    ,(*(infs->v + i))->val->sym->n
+    ,(*(infs->v + i))->val->sym->v
+    );
+    for (j = 0; j < (*(infs->v + i))->vals->n; ++j)
+      printf(" : %.*s %.*s"
+      ,(*((*(infs->v + i))->vals->v + j))->nam->sym->n
+      ,(*((*(infs->v + i))->vals->v + j))->nam->sym->v
+      ,(*((*(infs->v + i))->vals->v + j))->sym->n
+      ,(*((*(infs->v + i))->vals->v + j))->sym->v
+      );
+    putchar('\n');
+  }
+}
+#endif
+
+static int
+infsChk(
+  const infs_t *infs
+ ,const char *prg
+){
+  unsigned int i;
+  unsigned int j;
+  int r;
+
+  r = 0;
+  if (!infs)
+    return (r);
+  for (i = 0; i < infs->n; ++i)
+    for (j = i + 1; j < infs->n; ++j)
+      if ((*(infs->v + i))->val->nam == (*(infs->v + j))->val->nam
+       && (*(infs->v + i))->val != (*(infs->v + j))->val) {
+        fprintf(stderr, "%s: unresolvable \"%.*s\": \"%.*s\" @%s:%u vs \"%.*s\" @%s:%u\n"
+        ,prg
+        ,(*(infs->v + i))->val->nam->sym->n
+        ,(*(infs->v + i))->val->nam->sym->v
+        ,(*(infs->v + i))->val->sym->n
+        ,(*(infs->v + i))->val->sym->v
+        ,(*(infs->v + i))->fil
+        ,(*(infs->v + i))->row
+        ,(*(infs->v + j))->val->sym->n
+        ,(*(infs->v + j))->val->sym->v
+        ,(*(infs->v + j))->fil
+        ,(*(infs->v + j))->row
+        );
+        r = 1;
+      }
+  return (r);
+}
+
+static int
+nodChk(
+  const nod_t *nod
+ ,const char *prg
+){
+  int r;
+
+  r = 0;
+  if (!nod)
+    return (r);
+  r |= infsChk(nod->infsV, prg);
+  r |= infsChk(nod->infsO, prg);
+  r |= nodChk(nod->nodV, prg);
+  r |= nodChk(nod->nodO, prg);
+  return (r);
+}
+
+/********************************************************************************/
+
+typedef struct bld bld_t;
+
+struct bld {
+  vals_t *vals;
+  infs_t *infs;
+  nod_t *nod;
+  unsigned long h; /* bldHsh of vals, infs, c and x */
+  unsigned int c; /* with -e the bound nod is built under, else 0 */
+  unsigned int b; /* -j: the bound nod is built under, of use when it has no val */
+  vals_t *x; /* with -e the vals of the nams of vals tested false on the way, else 0 */
+  unsigned int w; /* --memo-limit: nodes expanded to build it */
+  unsigned int u; /* --memo-limit: hits, halved at each eviction */
+};
+
+/* hash of the (vals, infs, c, x) memo key, consistent with bldCmp */
+static unsigned long
+bldHsh(
+  const vals_t *vals
+ ,const infs_t *infs
+ ,unsigned int c
+ ,const vals_t *x
+){
+  unsigned long h;
+  unsigned int i;
+
+  h = 2166136261UL;
+  for (i = 0; i < vals->n; ++i)
+    h = (h ^ (unsigned long)*(vals->v + i)) * 16777619UL;
+  h = (h ^ vals->n) * 16777619UL;
+  for (i = 0; i < infs->n; ++i)
+    h = (h ^ (unsigned long)*(infs->v + i)) * 16777619UL;
+  h = (h ^ infs->n) * 16777619UL;
+  if (c)
+    h = (h ^ c) * 16777619UL;
+  for (i = 0; x && i < x->n; ++i)
+    h = (h ^ (unsigned long)*(x->v + i)) * 16777619UL;
+  return (h ^ h >> 15);
+}
+
+/* with an empty nod in nds, the rest in are */
+static bld_t *
+bldAre(
+  are_t *are
+ ,are_t *nds
+ ,const vals_t *vals
+ ,const infs_t *infs
+ ,unsigned long h
+){
+  bld_t *r;
+
+  if (!vals || !infs
+   || !(r = areAlc(are, sizeof (*r)))
+   || !(r->vals = valsAreDup(are, vals))
+   || !(r->infs = infsAreDup(are, infs))
+   || !(r->nod = areClc(nds, sizeof (*r->nod))))
+    return (0);
+  r->h = h;
+  r->c = 0;
+  r->b = 0;
+  r->x = 0;
+  r->w = 0;
+  r->u = 0;
+  return (r);
+}
+
+/* copy of bld in are, the same nod */
+static bld_t *
+bldDup(
+  are_t *are
+ ,const bld_t *bld
+){
+  bld_t *r;
+
+  if (!(r = areAlc(are, sizeof (*r))))
+    return (0);
+  *r = *bld;
+  if (!(r->vals = valsAreDup(are, bld->vals))
+   || !(r->infs = infsAreDup(are, bld->infs))
+   || (bld->x && !(r->x = valsAreDup(are, bld->x))))
+    return (0);
+  return (r);
+}
+
+#if DTC_DEBUG
+static void
+bldPrt(
+  const bld_t *bld
+){
+  if (!bld)
+    return;
+  valsPrt(bld->vals);
+  infsPrt(bld->infs);
+  nodPrt(bld->nod);
+}
+#endif
+
+static int
+bldCmp(
+  const bld_t *e1
+ ,const bld_t *e2
+){
+  int r;
+
+  if (e1->c != e2->c)
+    return (e1->c < e2->c ? -1 : 1);
+  if (e1->x != e2->x) {
+    if (!e1->x || !e2->x)
+      return (e1->x ? 1 : -1);
+    if ((r = valsCmp(e1->x, e2->x)))
+      return (r);
+  }
+  if ((r = valsCmp(e1->vals, e2->vals)))
+    return (r);
+  return (infsCmp(e1->infs, e2->infs));
+}
+
+/********************************************************************************/
+
+typedef struct blds blds_t;
+
+typedef struct cch cch_t;
+
+/* search counts (--stats), by level the number of tests above */
+typedef struct {
+  unsigned long hit; /* memo */
+  unsigned long mis;
+  unsigned long cut; /* misses cut by the lower bound */
+  unsigned long cch; /* misses found in the cache */
+  unsigned long evc; /* entries evicted (--memo-limit) */
+  unsigned long ovr; /* the most bytes over --memo-limit */
+  unsigned long *exp; /* nodes expanded */
+  unsigned long *cnd; /* candidates built */
+  unsigned long *prn; /* candidates pruned by the bound */
+  unsigned int pk; /* peak memo entries */
+} sts_t;
+
+/* open addressed (linear probe) hash table of bld_t, m a power of two */
+struct blds {
+  bld_t **v;
+  unsigned int m;
+  unsigned int n;
+  unsigned int vn; /* val_t ids */
+  bits_t *u; /* scratch of nodBldVal, only used before recursion */
+  bits_t *rv;
+  bits_t *cv;
+  const cch_t *cch; /* subproblem cache, may be 0 */
+  are_t are; /* the bld_t and their keys */
+  are_t nds; /* the nod_t and their infs, of evicted entries too while in use */
+  are_t scr; /* scratch of nodBld, reset (LIFO) to marks */
+  unsigned long lim; /* --memo-limit bytes (bldsSz), 0 for none */
+  unsigned long gc; /* with lim, the bytes bldsEvc is run over, ~0UL once it is of no use */
+  unsigned long xn; /* nodes expanded, with lim */
+  const nod_t ***rt; /* with lim, the nod_t * outside the table bldsEvc moves */
+  unsigned int rn;
+  unsigned int ra;
+  unsigned int l; /* level of nodBld */
+  unsigned int e; /* minimize e, then d, under the bound (-e) */
+  unsigned int cst; /* the val cst are not all 1 (-w) */
+  unsigned int s; /* tests of a nam down the O branches are one switch (-s) */
+  vals_t *xv; /* with -e the vals tested false on the way to nodBld, in order */
+  blds_t *shr; /* -j: the memo shared by the threads, else 0 */
+#if DTC_PTHREAD
+  pthread_rwlock_t *shl; /* the lock of shr */
+#endif
+  sts_t sts;
+};
+
+static blds_t *
+bldsNew(
+  unsigned int vn
+){
+  blds_t *r;
+
+  if (!(r = calloc(1, sizeof (*r))))
+    return (0);
+  r->vn = vn;
+  r->m = 1024;
+  /* a level tests one more val */
+  if (!(r->v = calloc(r->m, sizeof (*r->v)))
+   || !(r->u = bitsNew(vn))
+   || !(r->rv = bitsNew(vn))
+   || !(r->cv = bitsNew(vn))
+   || !(r->xv = valsNew())
+   || !(r->xv->v = malloc((vn ? vn : 1) * sizeof (*r->xv->v)))
+   || !(r->sts.exp = calloc((vn + 1) * 3, sizeof (*r->sts.exp)))) {
+    valsRefFre(r->xv);
+    bitsFre(r->cv);
+    bitsFre(r->rv);
+    bitsFre(r->u);
+    free(r->v);
+    free(r);
+    return (0);
+  }
+  r->sts.cnd = r->sts.exp + vn + 1;
+  r->sts.prn = r->sts.cnd + vn + 1;
+  return (r);
+}
+
+static bld_t *
+bldsFnd(
+  blds_t *blds
+ ,const vals_t *vals
+ ,const infs_t *infs
+ ,unsigned int c
+ ,const vals_t *x
+ ,unsigned long h
+){
+  bld_t *e;
+  bld_t k;
+  unsigned int i;
+
+  if (!blds || !vals || !infs)
+    return (0);
+  k.vals = (vals_t *)vals;
+  k.infs = (infs_t *)infs;
+  k.c = c;
+  k.x = (vals_t *)x;
+  for (i = h & (blds->m - 1); (e = *(blds->v + i)); i = (i + 1) & (blds->m - 1))
+    if (e->h == h && !bldCmp(&k, e))
+      return (e);
+  return (0);
+}
+
+/* double the table when more than half full */
+static int
+bldsGrw(
+  blds_t *blds
+){
+  bld_t **v;
+  unsigned int m;
+  unsigned int i;
+  unsigned int j;
+
+  m = blds->m * 2;
+  if (m < blds->m
+   || !(v = calloc(m, sizeof (*v))))
+    return (1);
+  for (i = 0; i < blds->m; ++i)
+    if (*(blds->v + i)) {
+      for (j = (*(blds->v + i))->h & (m - 1); *(v + j); j = (j + 1) & (m - 1));
+      *(v + j) = *(blds->v + i);
+    }
+  free(blds->v);
+  blds->v = v;
+  blds->m = m;
+  return (0);
+}
+
+static const bld_t *
+bldsAdd(
+  blds_t *blds
+ ,bld_t *bld
+){
+  unsigned int i;
+
+  if (!bld || !blds)
+    return (0);
+  if ((blds->n + 1) * 2 > blds->m
+   && bldsGrw(blds))
+    return (0);
+  for (i = bld->h & (blds->m - 1); *(blds->v + i); i = (i + 1) & (blds->m - 1));
+  *(blds->v + i) = bld;
+  if (++blds->n > blds->sts.pk)
+    blds->sts.pk = blds->n;
+  return (bld);
+}
+
+#if DTC_PTHREAD
+/*
+ * -j: the threads share the memo blds->shr. An entry with a val is the best
+ * of its key whatever bound it was built under, one without is of use under
+ * a bound no larger than the one it was built under.
+ */
+static const nod_t *
+bldsShrFnd(
+  blds_t *blds
+ ,const vals_t *vals
+ ,const infs_t *infs
+ ,unsigned int c
+ ,const vals_t *x
+ ,unsigned long h
+ ,unsigned int bd
+){
+  const bld_t *e;
+  const nod_t *n;
+
+  pthread_rwlock_rdlock(blds->shl);
+  n = (e = bldsFnd(blds->shr, vals, infs, c, x, h)) && (e->nod->val || e->b >= bd) ? e->nod : 0;
+  pthread_rwlock_unlock(blds->shl);
+  return (n);
+}
+
+/*
+ * add the finished bld to blds->shr, over an entry without a val built under a
+ * smaller bound, and return the nod of the entry (bld->nod when it is kept)
+ */
+static const nod_t *
+bldsShrAdd(
+  blds_t *blds
+ ,bld_t *bld
+){
+  bld_t *e;
+  nod_t *n;
+
+  pthread_rwlock_wrlock(blds->shl);
+  n = 0;
+  if ((e = bldsFnd(blds->shr, bld->vals, bld->infs, bld->c, bld->x, bld->h))) {
+    if (e->nod->val)
+      n = e->nod;
+    else if (!bld->nod->val && e->b >= bld->b)
+      n = bld->nod;
+    else if ((n = areAlc(&blds->shr->nds, sizeof (*n)))
+     && !nodCpy(&blds->shr->nds, n, bld->nod)) {
+      e->nod = n;
+      e->b = bld->b;
+    } else
+      n = 0;
+  } else if ((e = bldDup(&blds->shr->are, bld))
+   && (e->nod = n = areAlc(&blds->shr->nds, sizeof (*n)))
+   && !nodCpy(&blds->shr->nds, n, bld->nod)
+   && bldsAdd(blds->shr, e))
+    ;
+  else
+    n = 0;
+  pthread_rwlock_unlock(blds->shl);
+  return (n);
+}
+#endif
+
+/* add the counts of src to dst */
+static void
+bldsSts(
+  blds_t *dst
+ ,const blds_t *src
+){
+  unsigned int i;
+
+  dst->sts.hit += src->sts.hit;
+  dst->sts.mis += src->sts.mis;
+  dst->sts.cut += src->sts.cut;
+  dst->sts.cch += src->sts.cch;
+  dst->sts.evc += src->sts.evc;
+  if (src->sts.ovr > dst->sts.ovr)
+    dst->sts.ovr = src->sts.ovr;
+  for (i = 0; i <= dst->vn; ++i) {
+    *(dst->sts.exp + i) += *(src->sts.exp + i);
+    *(dst->sts.cnd + i) += *(src->sts.cnd + i);
+    *(dst->sts.prn + i) += *(src->sts.prn + i);
+  }
+  if (src->sts.pk > dst->sts.pk)
+    dst->sts.pk = src->sts.pk;
+}
+
+/* the entries of src join dst, the blocks they are in with them */
+static int
+bldsMov(
+  blds_t *dst
+ ,blds_t *src
+){
+  unsigned int i;
+  int r;
+
+  for (r = i = 0; i < src->m && !r; ++i)
+    if (*(src->v + i) && !bldsAdd(dst, *(src->v + i)))
+      r = 1;
+  areMov(&dst->are, &src->are);
+  areMov(&dst->nds, &src->nds);
+  return (r);
+}
+
+/* worth of keeping an entry, the work to build it again times its use */
+static double
+bldWth(
+  const bld_t *bld
+){
+  return (((double)bld->w + 1) * ((double)bld->u + 1));
+}
+
+static int
+bldWthCmp(
+  const bld_t **e1
+ ,const bld_t **e2
+){
+  double w1;
+  double w2;
+
+  unsigned int i;
+
+  w1 = bldWth(*e1);
+  w2 = bldWth(*e2);
+  if (w1 != w2)
+    return (w1 > w2 ? -1 : 1);
+  /* ties by the ids of the key, the table order is of pointers */
+  if ((*e1)->vals->n != (*e2)->vals->n)
+    return ((*e1)->vals->n < (*e2)->vals->n ? -1 : 1);
+  for (i = 0; i < (*e1)->vals->n; ++i)
+    if ((*((*e1)->vals->v + i))->id != (*((*e2)->vals->v + i))->id)
+      return ((*((*e1)->vals->v + i))->id < (*((*e2)->vals->v + i))->id ? -1 : 1);
+  if ((*e1)->infs->n != (*e2)->infs->n)
+    return ((*e1)->infs->n < (*e2)->infs->n ? -1 : 1);
+  for (i = 0; i < (*e1)->infs->n; ++i)
+    if ((*((*e1)->infs->v + i))->id != (*((*e2)->infs->v + i))->id)
+      return ((*((*e1)->infs->v + i))->id < (*((*e2)->infs->v + i))->id ? -1 : 1);
+  if ((*e1)->c != (*e2)->c)
+    return ((*e1)->c < (*e2)->c ? -1 : 1);
+  if (!(*e1)->x || !(*e2)->x)
+    return (!(*e1)->x - !(*e2)->x);
+  if ((*e1)->x->n != (*e2)->x->n)
+    return ((*e1)->x->n < (*e2)->x->n ? -1 : 1);
+  for (i = 0; i < (*e1)->x->n; ++i)
+    if ((*((*e1)->x->v + i))->id != (*((*e2)->x->v + i))->id)
+      return ((*((*e1)->x->v + i))->id < (*((*e2)->x->v + i))->id ? -1 : 1);
+  return (0);
+}
+
+/*
+ * --memo-limit of lim bytes (0 for none): bldsEvc runs at two thirds of it
+ * and copies what it keeps in the last third. The blocks of the arenas are a
+ * 64th of it (from 1k to ARE_B), so a small lim is not taken by whole blocks.
+ */
+static void
+bldsLim(
+  blds_t *blds
+ ,unsigned long lim
+){
+  unsigned long z;
+
+  blds->lim = lim;
+  blds->gc = lim / 3 * 2;
+  z = lim / 64 / ARE_A * ARE_A;
+  if (!lim || z >= ARE_B)
+    z = 0;
+  else if (z < 1024)
+    z = 1024;
+  blds->are.z = z;
+  blds->nds.z = z;
+  blds->scr.z = z;
+}
+
+/* the bytes counted against lim: the arenas, their free blocks and the table */
+static unsigned long
+bldsSz(
+  const blds_t *blds
+){
+  return (areSz(&blds->are) + areSz(&blds->nds) + areSz(&blds->scr) + blds->m * sizeof (*blds->v));
+}
+
+/* with lim, note how far over it the memo is (over_limit_bytes, stderr) */
+static void
+bldsOvr(
+  blds_t *blds
+){
+  unsigned long n;
+
+  n = bldsSz(blds);
+  if (blds->lim
+   && n > blds->lim
+   && n - blds->lim > blds->sts.ovr)
+    blds->sts.ovr = n - blds->lim;
+}
+
+/* with lim, n is a root of bldsEvc until popped (--blds->rn) */
+static int
+bldsRt(
+  blds_t *blds
+ ,const nod_t **n
+){
+  const nod_t ***v;
+
+  if (blds->rn == blds->ra) {
+    if (!(v = realloc(blds->rt, (blds->ra + 64) * sizeof (*v))))
+      return (1);
+    blds->rt = v;
+    blds->ra += 64;
+  }
+  *(blds->rt + blds->rn++) = n;
+  return (0);
+}
+
+/*
+ * --memo-limit: when the memo takes more than blds->gc bytes (bldsSz), move
+ * the nod_t of the roots (the nodes being built on the nodBld stack and the
+ * earlier top levels) and of n, and those they refer to, to a new nds. Then
+ * keep the most worthy entries, copied to a new are with their nodes, while
+ * what is left takes less than a third of blds->lim, and forget the rest: a
+ * node of a forgotten entry is kept while it is used, and a forgotten entry
+ * costs only its search again when it is met again.
+ */
+static int
+bldsEvc(
+  blds_t *blds
+ ,const nod_t **n
+){
+  bld_t **b;
+  bld_t **v;
+  bld_t *e;
+  are_t a;
+  are_t d;
+  unsigned long k;
+  unsigned long l;
+  unsigned int m;
+  unsigned int c;
+  unsigned int h;
+  unsigned int i;
+  unsigned int j;
+
+  k = bldsSz(blds);
+  bldsOvr(blds);
+  if (!(b = malloc((blds->n ? blds->n : 1) * sizeof (*b))))
+    return (1);
+  for (c = i = 0; i < blds->m; ++i)
+    if (*(blds->v + i))
+      *(b + c++) = *(blds->v + i);
+  qsort(b, c, sizeof (*b), (int(*)(const void *, const void *))bldWthCmp);
+  v = 0;
+  memset(&a, 0, sizeof (a));
+  memset(&d, 0, sizeof (d));
+  a.z = blds->are.z;
+  d.z = blds->nds.z;
+  for (j = 0; j < blds->rn; ++j)
+    if (nodMov(&d, *(blds->rt + j)))
+      goto error;
+  if (nodMov(&d, n))
+    goto error;
+  /* the scratch stays, the table is sized to what is kept (as bldsAdd grows it) */
+  l = areSz(&blds->scr);
+  for (m = 1024, i = 0; i < c; ++i) {
+    for (; (i + 1) * 2 > m; m *= 2);
+    if (l + a.n + d.n + m * sizeof (*v) >= blds->lim / 3)
+      break;
+    if (!(e = bldDup(&a, *(b + i)))
+     || nodMov(&d, (const nod_t **)&e->nod))
+      goto error;
+    e->u /= 2;
+    *(b + i) = e;
+  }
+  for (m = 1024; (i + 1) * 2 > m; m *= 2);
+  if (!(v = calloc(m, sizeof (*v))))
+    goto error;
+  for (j = 0; j < i; ++j) {
+    e = *(b + j);
+    for (h = e->h & (m - 1); *(v + h); h = (h + 1) & (m - 1));
+    *(v + h) = e;
+  }
+  blds->sts.evc += c - i;
+  blds->n = i;
+  free(blds->v);
+  blds->v = v;
+  blds->m = m;
+  areFre(&blds->are);
+  blds->are = a;
+  areFre(&blds->nds);
+  blds->nds = d;
+  /*
+   * what is left is in use and may be over lim, the next run is at twice it.
+   * When it freed nothing, or it kept no entry as the nodes in use take the
+   * room, another run would only throw away the search since: there is none.
+   */
+  bldsOvr(blds);
+  l = bldsSz(blds);
+  if (l >= k || (c && !i))
+    blds->gc = ~0UL;
+  else
+    blds->gc = l * 2 > blds->lim / 3 * 2 ? l * 2 : blds->lim / 3 * 2;
+  free(b);
+  return (0);
+error:
+  /* out of memory, the build fails with the old nds part forwarded */
+  areFre(&d);
+  areFre(&a);
+  free(v);
+  free(b);
+  return (1);
+}
+
+#if DTC_DEBUG
+static void
+bldsPrt(
+  const blds_t *blds
+){
+  unsigned int i;
+
+  if (!blds)
+    return;
+  puts("blds(");
+  for (i = 0; i < blds->m; ++i)
+    if (*(blds->v + i))
+      bldPrt(*(blds->v + i));
+  puts(")");
+}
+#endif
+
+static void
+bldsFre(
+  blds_t *blds
+){
+  if (!blds)
+    return;
+  areFre(&blds->are);
+  areFre(&blds->nds);
+  areFre(&blds->scr);
+  bitsFre(blds->u);
+  bitsFre(blds->rv);
+  bitsFre(blds->cv);
+  valsRefFre(blds->xv);
+  free(blds->sts.exp);
+  free(blds->rt);
+  free(blds->v);
+  free(blds);
+}
+
+/********************************************************************************/
+
+/*
+ * Subproblem cache file (-c dir), mapped read only. All words are unsigned int:
+ *  header of CCH_H words
+ *  vals, CCH_VW words each: nam sym offset, length, val sym offset, length, independent
+ *  infs, CCH_IW words each: val, number of vals, offset of vals
+ *  vals of the infs
+ *  entries, offset of each
+ *  hash, entry + 1 by entry hash (linear probe, hm a power of two)
+ *  entry: CCH_EW words (hash, vals, infs, d, val, nodV + 1, nodO + 1, infsV, infsO)
+ *   then the vals, infs, infsV and infsO
+ *  sym bytes
+ * Vals and infs of the file are matched to those of the tables by content
+ * when loaded. An entry is only used when everything it refers to matches
+ * and its nodes agree with how nodBld builds them, otherwise it is a miss.
+ */
+#define CCH_MGC 0x43435444 /* "DTCC" */
+#define CCH_MGCI 0
+#define CCH_Q 1
+#define CCH_NW 2
+#define CCH_NV 3
+#define CCH_NI 4
+#define CCH_NE 5
+#define CCH_HM 6
+#define CCH_VO 7
+#define CCH_IO 8
+#define CCH_EO 9
+#define CCH_HO 10
+#define CCH_SO 11
+#define CCH_SN 12
+#define CCH_H 13
+#define CCH_VW 5
+#define CCH_IW 3
+#define CCH_EW 9
+
+struct cch {
+  const unsigned int *w; /* mapped file (or --watch image), 0 when none */
+  unsigned long sz;
+  unsigned int map; /* w is mapped, else the image is of the caller */
+  const val_t **vt; /* file val to val, 0 when not matched */
+  const inf_t **it; /* file inf to inf, 0 when not matched */
+  unsigned int *vh; /* content hash by val_t id */
+  unsigned int *ih; /* content hash by inf_t id */
+  unsigned int vn;
+  unsigned int in;
+};
+
+static unsigned int
+cchMix(
+  unsigned int h
+){
+  h ^= h >> 16;
+  h *= 0x45d9f3bU;
+  h ^= h >> 16;
+  return (h);
+}
+
+static unsigned int
+cchSymHsh(
+  unsigned int h
+ ,const sym_t *sym
+){
+  unsigned int i;
+
+  for (i = 0; i < sym->n; ++i)
+    h = (h ^ sym->v[i]) * 16777619U;
+  return ((h ^ 0x100) * 16777619U);
+}
+
+/* hash of the (vals, infs) memo key, from the content of its vals and infs */
+static unsigned int
+cchHsh(
+  const cch_t *cch
+ ,const vals_t *vals
+ ,const infs_t *infs
+){
+  unsigned int a;
+  unsigned int b;
+  unsigned int i;
+
+  for (a = i = 0; i < vals->n; ++i)
+    a += cchMix(*(cch->vh + (*(vals->v + i))->id));
+  for (b = i = 0; i < infs->n; ++i)
+    b += cchMix(*(cch->ih + (*(infs->v + i))->id));
+  return (cchMix(cchMix(a + vals->n) ^ (b + infs->n)));
+}
+
+/* compare a sym to bytes, in symCmp order */
+static int
+cchSymCmp(
+  const unsigned char *v
+ ,unsigned int n
+ ,const sym_t *sym
+){
+  unsigned int i;
+  int r;
+
+  i = n < sym->n ? n : sym->n;
+  r = memcmp(v, sym->v, i);
+  if (r < 0)
+    return (-1);
+  if (r > 0)
+    return (1);
+  if (n < sym->n)
+    return (-1);
+  if (n > sym->n)
+    return (1);
+  return (0);
+}
+
+/* val of the tables for a val of the file */
+static const val_t *
+cchVal(
+  const cch_t *cch
+ ,const nams_t *nams
+ ,unsigned int v
+){
+  const unsigned char *s;
+  const unsigned int *e;
+  const vals_t *vals;
+  unsigned int lo;
+  unsigned int hi;
+  unsigned int mid;
+  int c;
+
+  s = (const unsigned char *)(cch->w + *(cch->w + CCH_SO));
+  e = cch->w + *(cch->w + CCH_VO) + v * CCH_VW;
+  if (*(e + 0) > *(cch->w + CCH_SN) || *(e + 1) > *(cch->w + CCH_SN) - *(e + 0)
+   || *(e + 2) > *(cch->w + CCH_SN) || *(e + 3) > *(cch->w + CCH_SN) - *(e + 2))
+    return (0);
+  for (lo = 0, hi = nams->n; lo < hi;) {
+    mid = lo + (hi - lo) / 2;
+    if (!(c = cchSymCmp(s + *(e + 0), *(e + 1), (*(nams->v + mid))->sym)))
+      break;
+    if (c < 0)
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+  if (lo >= hi)
+    return (0);
+  vals = (*(nams->v + mid))->vals;
+  for (lo = 0, hi = vals->n; lo < hi;) {
+    mid = lo + (hi - lo) / 2;
+    if (!(c = cchSymCmp(s + *(e + 2), *(e + 3), (*(vals->v + mid))->sym)))
+      break;
+    if (c < 0)
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+  if (lo >= hi
+   || !*(e + 4) != !(*(vals->v + mid))->ib)
+    return (0);
+  return (*(vals->v + mid));
+}
+
+/* inf of the tables for an inf of the file, b is scratch */
+static const inf_t *
+cchInf(
+  const cch_t *cch
+ ,const infs_t *infs
+ ,unsigned int f
+ ,bits_t *b
+){
+  const unsigned int *e;
+  const inf_t **r;
+  const val_t *val;
+  unsigned int i;
+  unsigned int k;
+
+  e = cch->w + *(cch->w + CCH_IO) + f * CCH_IW;
+  if (*(e + 0) >= *(cch->w + CCH_NV)
+   || !(val = *(cch->vt + *(e + 0)))
+   || *(e + 2) > *(cch->w + CCH_NW)
+   || *(e + 1) > *(cch->w + CCH_NW) - *(e + 2))
+    return (0);
+  bitsClr(b);
+  for (i = 0; i < *(e + 1); ++i) {
+    k = *(cch->w + *(e + 2) + i);
+    if (k >= *(cch->w + CCH_NV) || !*(cch->vt + k))
+      return (0);
+    bitsSet(b, (*(cch->vt + k))->id);
+  }
+  if (!(r = bsearch(val, infs->v, infs->n, sizeof (*infs->v), (int(*)(const void *, const void *))infsValSchCmp)))
+    return (0);
+  while (r > infs->v && (*(r - 1))->val == val)
+    --r;
+  for (; r < infs->v + infs->n && (*r)->val == val; ++r)
+    if ((*r)->vals->n == *(e + 1)
+     && bitsAndCnt((*r)->vb, b) == *(e + 1))
+      return (*r);
+  return (0);
+}
+
+static void
+cchFre(
+  cch_t *cch
+){
+  if (!cch)
+    return;
+  if (cch->w && cch->map)
+    munmap((void *)cch->w, cch->sz);
+  free(cch->vt);
+  free(cch->it);
+  free(cch->vh);
+  free(cch->ih);
+  free(cch);
+}
+
+/* content hashes of the tables and, when fil is a valid cache, the mapped file */
+/* or, without fil, the image of cchSav */
+static cch_t *
+cchNew(
+  const char *prg
+ ,const char *fil
+ ,const unsigned int *img
+ ,const struct csv *csv
+ ,unsigned int q
+){
+  cch_t *r;
+  const unsigned int *w;
+  const val_t *val;
+  const inf_t *inf;
+  bits_t *b;
+  struct stat st;
+  unsigned int h;
+  unsigned int i;
+  unsigned int j;
+  int fd;
+
+  if (!(r = calloc(1, sizeof (*r)))
+   || !(r->vh = malloc((csv->valn ? csv->valn : 1) * sizeof (*r->vh)))
+   || !(r->ih = malloc((csv->infs->n ? csv->infs->n : 1) * sizeof (*r->ih)))) {
+    cchFre(r);
+    return (0);
+  }
+  r->vn = csv->valn;
+  r->in = csv->infs->n;
+  for (i = 0; i < csv->nams->n; ++i)
+    for (j = 0; j < (*(csv->nams->v + i))->vals->n; ++j) {
+      val = *((*(csv->nams->v + i))->vals->v + j);
+      h = cchSymHsh(cchSymHsh(2166136261U, val->nam->sym), val->sym);
+      *(r->vh + val->id) = (h ^ !!val->ib) * 16777619U;
+    }
+  for (i = 0; i < csv->infs->n; ++i) {
+    inf = *(csv->infs->v + i);
+    for (h = j = 0; j < inf->vals->n; ++j)
+      h += cchMix(*(r->vh + (*(inf->vals->v + j))->id));
+    *(r->ih + inf->id) = cchMix(h ^ *(r->vh + inf->val->id));
+  }
+
+  if (!fil) {
+    if (!img)
+      return (r);
+    w = img;
+    r->sz = (unsigned long)*(w + CCH_NW) * sizeof (*w);
+  } else {
+    if ((fd = open(fil, O_RDONLY)) < 0)
+      return (r);
+    w = MAP_FAILED;
+    if (fstat(fd, &st) || st.st_size < (off_t)(CCH_H * sizeof (*w))
+     || (w = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED) {
+      close(fd);
+      fprintf(stderr, "%s: ignoring cache %s\n", prg, fil);
+      return (r);
+    }
+    close(fd);
+    r->sz = st.st_size;
+    r->map = 1;
+  }
+  r->w = w;
+#define W(x) (*(w + (x)))
+  if (W(CCH_MGCI) != CCH_MGC || W(CCH_Q) != q
+   || (unsigned long)W(CCH_NW) * sizeof (*w) != r->sz
+   || W(CCH_VO) > W(CCH_NW) || W(CCH_NV) > (W(CCH_NW) - W(CCH_VO)) / CCH_VW
+   || W(CCH_IO) > W(CCH_NW) || W(CCH_NI) > (W(CCH_NW) - W(CCH_IO)) / CCH_IW
+   || W(CCH_EO) > W(CCH_NW) || W(CCH_NE) > W(CCH_NW) - W(CCH_EO)
+   || W(CCH_HO) > W(CCH_NW) || W(CCH_HM) > W(CCH_NW) - W(CCH_HO)
+   || !W(CCH_HM) || W(CCH_HM) & (W(CCH_HM) - 1) || W(CCH_HM) <= W(CCH_NE)
+   || W(CCH_SO) > W(CCH_NW)
+   || W(CCH_SN) > (W(CCH_NW) - W(CCH_SO)) * sizeof (*w)) {
+#undef W
+    fprintf(stderr, "%s: ignoring cache %s\n", prg, fil ? fil : "image");
+    if (r->map)
+      munmap((void *)r->w, r->sz);
+    r->w = 0;
+    return (r);
+  }
+  b = 0;
+  if (!(r->vt = calloc(*(w + CCH_NV) ? *(w + CCH_NV) : 1, sizeof (*r->vt)))
+   || !(r->it = calloc(*(w + CCH_NI) ? *(w + CCH_NI) : 1, sizeof (*r->it)))
+   || !(b = bitsNew(csv->valn))) {
+    cchFre(r);
+    return (0);
+  }
+  for (i = 0; i < *(w + CCH_NV); ++i)
+    *(r->vt + i) = cchVal(r, csv->nams, i);
+  for (i = 0; i < *(w + CCH_NI); ++i)
+    *(r->it + i) = cchInf(r, csv->infs, i, b);
+  bitsFre(b);
+  return (r);
+}
+
+static int
+cchValIdCmp(
+  const val_t **e1
+ ,const val_t **e2
+){
+  if ((*e1)->id < (*e2)->id)
+    return (-1);
+  if ((*e1)->id > (*e2)->id)
+    return (1);
+  return (0);
+}
+
+static int
+cchInfIdCmp(
+  const inf_t **e1
+ ,const inf_t **e2
+){
+  if ((*e1)->id < (*e2)->id)
+    return (-1);
+  if ((*e1)->id > (*e2)->id)
+    return (1);
+  return (0);
+}
+
+/* entry e of the file, 0 when out of bounds */
+static const unsigned int *
+cchEnt(
+  const cch_t *cch
+ ,unsigned int e
+){
+  const unsigned int *r;
+  unsigned long n;
+
+  if (e >= *(cch->w + CCH_NE)
+   || *(cch->w + *(cch->w + CCH_EO) + e) > *(cch->w + CCH_NW) - CCH_EW)
+    return (0);
+  r = cch->w + *(cch->w + *(cch->w + CCH_EO) + e);
+  n = (unsigned long)*(r + 1) + *(r + 2) + *(r + 7) + *(r + 8);
+  if (n > (unsigned long)(cch->w + *(cch->w + CCH_NW) - r) - CCH_EW)
+    return (0);
+  return (r);
+}
+
+/* translate n infs of the file, in inf_t id order, 0 when one does not match */
+static infs_t *
+cchInfs(
+  are_t *are
+ ,const cch_t *cch
+ ,const unsigned int *v
+ ,unsigned int n
+){
+  infs_t *r;
+
+  if (!(r = infsAre(are, n)))
+    return (0);
+  for (r->n = 0; r->n < n; ++r->n)
+    if (*(v + r->n) >= *(cch->w + CCH_NI)
+     || !(*(r->v + r->n) = *(cch->it + *(v + r->n))))
+      return (0);
+  qsort(r->v, r->n, sizeof (*r->v), (int(*)(const void *, const void *))cchInfIdCmp);
+  return (r);
+}
+
+/* translate the key of an entry (in are), in id order, 1 when it does not match */
+static int
+cchKey(
+  are_t *are
+ ,const cch_t *cch
+ ,const unsigned int *e
+ ,vals_t **vals
+ ,infs_t **infs
+){
+  unsigned int i;
+
+  if (!(*vals = valsAre(are, *(e + 1)))
+   || !(*infs = cchInfs(are, cch, e + CCH_EW + *(e + 1), *(e + 2))))
+    return (1);
+  for ((*vals)->n = 0; (*vals)->n < *(e + 1); ++(*vals)->n)
+    if (*(e + CCH_EW + (*vals)->n) >= *(cch->w + CCH_NV)
+     || !(*((*vals)->v + (*vals)->n) = *(cch->vt + *(e + CCH_EW + (*vals)->n))))
+      return (1);
+  qsort((*vals)->v, (*vals)->n, sizeof (*(*vals)->v), (int(*)(const void *, const void *))cchValIdCmp);
+  for (i = 1; i < (*vals)->n; ++i)
+    if (*((*vals)->v + i) == *((*vals)->v + i - 1))
+      return (1);
+  return (0);
+}
+
+/* node of entry e for its key vals and infs, *n is 0 when it does not match */
+static int
+cchNod(
+  blds_t *blds
+ ,const unsigned int *e
+ ,const vals_t *vals
+ ,const infs_t *infs
+ ,const nod_t **n
+){
+  const cch_t *cch;
+  const unsigned int *c;
+  bld_t *bld;
+  vals_t *cv;
+  infs_t *ci;
+  const nod_t *t;
+  nod_t r;
+  areMrk_t m;
+  unsigned long h;
+  unsigned int k;
+  unsigned int i;
+
+  *n = 0;
+  cch = blds->cch;
+  h = bldHsh(vals, infs, 0, 0);
+  if ((bld = bldsFnd(blds, vals, infs, 0, 0, h))) {
+    *n = bld->nod;
+    return (0);
+  }
+#if DTC_PTHREAD
+  /* the bound is not known here, an entry without a val is not of use */
+  if (blds->shr && (t = bldsShrFnd(blds, vals, infs, 0, 0, h, ~0U)) && t->val) {
+    *n = t;
+    return (0);
+  }
+#endif
+  if (*(e + 4) >= *(cch->w + CCH_NV))
+    return (0);
+  for (i = 0; i < vals->n && *(vals->v + i) != *(cch->vt + *(e + 4)); ++i);
+  if (i == vals->n)
+    return (0);
+  memset(&r, 0, sizeof (r));
+  r.val = *(vals->v + i);
+  m = areMrk(&blds->scr);
+  if ((*(e + 7) && !(r.infsV = cchInfs(&blds->scr, cch, e + CCH_EW + *(e + 1) + *(e + 2), *(e + 7))))
+   || (*(e + 8) && !(r.infsO = cchInfs(&blds->scr, cch, e + CCH_EW + *(e + 1) + *(e + 2) + *(e + 7), *(e + 8)))))
+    goto miss;
+  for (k = 5; k <= 6; ++k) {
+    if (!*(e + k))
+      continue;
+    if (!(c = cchEnt(cch, *(e + k) - 1))
+     || *(c + 1) >= *(e + 1)
+     || cchKey(&blds->scr, cch, c, &cv, &ci))
+      goto miss;
+    if (cchNod(blds, c, cv, ci, &t))
+      goto error;
+    if (!t || !t->val)
+      goto miss;
+    if (k == 5)
+      r.nodV = t;
+    else
+      r.nodO = t;
+  }
+  /* as in nodBldVal */
+  if (r.nodV && r.nodO)
+    r.d = 1 + (r.nodV->d > r.nodO->d ? r.nodV->d : r.nodO->d);
+  else if (r.nodV)
+    r.d = 1 + r.nodV->d;
+  else if (r.nodO)
+    r.d = 1 + r.nodO->d;
+  r.d += r.val->cst - 1;
+  if (r.d != *(e + 3))
+    goto miss;
+#if DTC_PTHREAD
+  /* -j: it has a val, the threads share it as nodBldAdd does */
+  if (blds->shr) {
+    bld_t k;
+
+    memset(&k, 0, sizeof (k));
+    k.vals = (vals_t *)vals;
+    k.infs = (infs_t *)infs;
+    k.nod = &r;
+    k.h = h;
+    if (!(*n = bldsShrAdd(blds, &k)))
+      goto error;
+    areRst(&blds->scr, m);
+    return (0);
+  }
+#endif
+  if (!(bld = bldAre(&blds->are, &blds->nds, vals, infs, h))
+   || nodCpy(&blds->nds, bld->nod, &r)
+   || !bldsAdd(blds, bld))
+    goto error;
+  areRst(&blds->scr, m);
+  *n = bld->nod;
+  return (0);
+miss:
+  areRst(&blds->scr, m);
+  return (0);
+error:
+  areRst(&blds->scr, m);
+  return (1);
+}
+
+/* look for (vals, infs) in the file, *n is 0 when not found */
+static int
+cchFnd(
+  blds_t *blds
+ ,const vals_t *vals
+ ,const infs_t *infs
+ ,const nod_t **n
+){
+  const cch_t *cch;
+  const unsigned int *e;
+  vals_t *kv;
+  infs_t *ki;
+  areMrk_t a;
+  unsigned int h;
+  unsigned int m;
+  unsigned int i;
+  unsigned int j;
+  int r;
+
+  *n = 0;
+  if (!(cch = blds->cch) || !cch->w)
+    return (0);
+  h = cchHsh(cch, vals, infs);
+  m = *(cch->w + CCH_HM);
+  a = areMrk(&blds->scr);
+  for (i = h & (m - 1), j = 0; j < m && *(cch->w + *(cch->w + CCH_HO) + i); i = (i + 1) & (m - 1), ++j) {
+    r = 0;
+    if ((e = cchEnt(cch, *(cch->w + *(cch->w + CCH_HO) + i) - 1))
+     && *e == h
+     && *(e + 1) == vals->n
+     && *(e + 2) == infs->n
+     && !cchKey(&blds->scr, cch, e, &kv, &ki)
+     && !valsCmp(kv, vals) && !infsCmp(ki, infs))
+      r = cchNod(blds, e, vals, infs, n);
+    areRst(&blds->scr, a);
+    if (r || *n)
+      return (r);
+  }
+  return (0);
+}
+
+static int
+cchNodCmp(
+  const bld_t **e1
+ ,const bld_t **e2
+){
+  if ((unsigned long)(*e1)->nod < (unsigned long)(*e2)->nod)
+    return (-1);
+  if ((unsigned long)(*e1)->nod > (unsigned long)(*e2)->nod)
+    return (1);
+  return (0);
+}
+
+/* entry + 1 of the bld of nod in the sorted b, 0 for none */
+static unsigned int
+cchNodIdx(
+  const bld_t **b
+ ,unsigned int n
+ ,const nod_t *nod
+){
+  bld_t k;
+  const bld_t *kp;
+  const bld_t **r;
+
+  if (!nod)
+    return (0);
+  k.nod = (nod_t *)nod;
+  kp = &k;
+  if (!(r = bsearch(&kp, b, n, sizeof (*b), (int(*)(const void *, const void *))cchNodCmp)))
+    return (0);
+  return (r - b + 1);
+}
+
+/* write the solved entries of blds to fil or, without fil, replace *img with them */
+static int
+cchSav(
+  const char *fil
+ ,unsigned int **img
+ ,const struct csv *csv
+ ,const blds_t *blds
+ ,const cch_t *cch
+ ,unsigned int q
+){
+  const bld_t **b;
+  const bld_t *d;
+  unsigned int *w;
+  unsigned char *s;
+  unsigned char *x;
+  char *tmp;
+  FILE *fp;
+  unsigned long nw;
+  unsigned int ne;
+  unsigned int hm;
+  unsigned int i;
+  unsigned int j;
+  unsigned int k;
+  unsigned int o;
+  int r;
+
+  r = 1;
+  w = 0;
+  x = 0;
+  tmp = 0;
+  if (!(b = malloc((blds->n ? blds->n : 1) * sizeof (*b))))
+    return (r);
+  for (ne = i = 0; i < blds->m; ++i)
+    if (*(blds->v + i) && (*(blds->v + i))->nod->val)
+      *(b + ne++) = *(blds->v + i);
+  qsort(b, ne, sizeof (*b), (int(*)(const void *, const void *))cchNodCmp);
+  /* an entry whose tested child was evicted (--memo-limit) is left out, then its parents */
+  if (!(x = malloc(ne ? ne : 1)))
+    goto exit;
+  do {
+    for (k = i = 0; i < ne; ++i) {
+      d = *(b + i);
+      k += (*(x + i) = (d->nod->nodV && d->nod->nodV->val && !cchNodIdx(b, ne, d->nod->nodV))
+        || (d->nod->nodO && d->nod->nodO->val && !cchNodIdx(b, ne, d->nod->nodO)));
+    }
+    for (j = i = 0; k && i < ne; ++i)
+      if (!*(x + i))
+        *(b + j++) = *(b + i);
+    if (k)
+      ne = j;
+  } while (k);
+  for (hm = 1; hm <= ne * 2; hm *= 2);
+
+  /* size */
+  nw = CCH_H + (unsigned long)cch->vn * CCH_VW + (unsigned long)cch->in * CCH_IW + ne + hm;
+  for (i = 0; i < csv->infs->n; ++i)
+    nw += (*(csv->infs->v + i))->vals->n;
+  for (i = 0; i < ne; ++i) {
+    d = *(b + i);
+    nw += CCH_EW + d->vals->n + d->infs->n
+        + (d->nod->infsV ? d->nod->infsV->n : 0)
+        + (d->nod->infsO ? d->nod->infsO->n : 0);
+  }
+  for (o = i = 0; i < csv->nams->n; ++i) {
+    o += (*(csv->nams->v + i))->sym->n;
+    for (j = 0; j < (*(csv->nams->v + i))->vals->n; ++j)
+      o += (*((*(csv->nams->v + i))->vals->v + j))->sym->n;
+  }
+  nw += (o + sizeof (*w) - 1) / sizeof (*w);
+  if (nw > ~0U
+   || !(w = calloc(nw, sizeof (*w)))
+   || (fil && !(tmp = malloc(strlen(fil) + 5))))
+    goto exit;
+
+  *(w + CCH_MGCI) = CCH_MGC;
+  *(w + CCH_Q) = q;
+  *(w + CCH_NW) = nw;
+  *(w + CCH_NV) = cch->vn;
+  *(w + CCH_NI) = cch->in;
+  *(w + CCH_NE) = ne;
+  *(w + CCH_HM) = hm;
+  o = CCH_H;
+  *(w + CCH_VO) = o;
+  o += cch->vn * CCH_VW;
+  *(w + CCH_IO) = o;
+  o += cch->in * CCH_IW;
+  for (i = 0; i < csv->infs->n; ++i) {
+    const inf_t *inf;
+
+    inf = *(csv->infs->v + i);
+    *(w + *(w + CCH_IO) + inf->id * CCH_IW + 0) = inf->val->id;
+    *(w + *(w + CCH_IO) + inf->id * CCH_IW + 1) = inf->vals->n;
+    *(w + *(w + CCH_IO) + inf->id * CCH_IW + 2) = o;
+    for (j = 0; j < inf->vals->n; ++j)
+      *(w + o++) = (*(inf->vals->v + j))->id;
+  }
+  *(w + CCH_EO) = o;
+  o += ne;
+  *(w + CCH_HO) = o;
+  o += hm;
+  for (i = 0; i < ne; ++i) {
+    d = *(b + i);
+    *(w + *(w + CCH_EO) + i) = o;
+    *(w + o + 0) = cchHsh(cch, d->vals, d->infs);
+    *(w + o + 1) = d->vals->n;
+    *(w + o + 2) = d->infs->n;
+    *(w + o + 3) = d->nod->d;
+    *(w + o + 4) = d->nod->val->id;
+    *(w + o + 5) = cchNodIdx(b, ne, d->nod->nodV);
+    *(w + o + 6) = cchNodIdx(b, ne, d->nod->nodO);
+    *(w + o + 7) = d->nod->infsV ? d->nod->infsV->n : 0;
+    *(w + o + 8) = d->nod->infsO ? d->nod->infsO->n : 0;
+    for (j = *(w + o) & (hm - 1); *(w + *(w + CCH_HO) + j); j = (j + 1) & (hm - 1));
+    *(w + *(w + CCH_HO) + j) = i + 1;
+    o += CCH_EW;
+    for (j = 0; j < d->vals->n; ++j)
+      *(w + o++) = (*(d->vals->v + j))->id;
+    for (j = 0; j < d->infs->n; ++j)
+      *(w + o++) = (*(d->infs->v + j))->id;
+    for (j = 0; d->nod->infsV && j < d->nod->infsV->n; ++j)
+      *(w + o++) = (*(d->nod->infsV->v + j))->id;
+    for (j = 0; d->nod->infsO && j < d->nod->infsO->n; ++j)
+      *(w + o++) = (*(d->nod->infsO->v + j))->id;
+  }
+  *(w + CCH_SO) = o;
+  s = (unsigned char *)(w + o);
+  for (k = i = 0; i < csv->nams->n; ++i) {
+    const nam_t *nam;
+    unsigned int no;
+
+    nam = *(csv->nams->v + i);
+    no = k;
+    memcpy(s + k, nam->sym->v, nam->sym->n);
+    k += nam->sym->n;
+    for (j = 0; j < nam->vals->n; ++j) {
+      const val_t *val;
+
+      val = *(nam->vals->v + j);
+      *(w + CCH_H + val->id * CCH_VW + 0) = no;
+      *(w + CCH_H + val->id * CCH_VW + 1) = nam->sym->n;
+      *(w + CCH_H + val->id * CCH_VW + 2) = k;
+      *(w + CCH_H + val->id * CCH_VW + 3) = val->sym->n;
+      *(w + CCH_H + val->id * CCH_VW + 4) = !!val->ib;
+      memcpy(s + k, val->sym->v, val->sym->n);
+      k += val->sym->n;
+    }
+  }
+  *(w + CCH_SN) = k;
+  if (!fil) {
+    free(*img);
+    *img = w;
+    w = 0;
+    r = 0;
+    goto exit;
+  }
+
+  /* replace the file as a whole */
+  strcpy(tmp, fil);
+  strcat(tmp, ".tmp");
+  if (!(fp = fopen(tmp, "wb")))
+    goto exit;
+  if (fwrite(w, sizeof (*w), nw, fp) != nw) {
+    fclose(fp);
+    remove(tmp);
+    goto exit;
+  }
+  if (fclose(fp)
+   || rename(tmp, fil)) {
+    remove(tmp);
+    goto exit;
+  }
+  r = 0;
+exit:
+  free(tmp);
+  free(w);
+  free(x);
+  free(b);
+  return (r);
+}
+
+/*
+ * Lower bound of the tests on the longest path of a node for vals and infs.
+ * Each test takes at most one of an inf's vals out of vals and an inf is only
+ * resolved with its last one, so the path where it holds tests them all,
+ * unless an inf with the same val is resolved first. Infs with dependent vals
+ * can also be stripped, so their val is skipped. Infs are in infCmp order.
+ * With -w it is of the cst of the tests. blds->u is scratch.
+ */
+static unsigned int
+nodLb(
+  blds_t *blds
+ ,const vals_t *vals
+ ,const infs_t *infs
+){
+  const inf_t *inf;
+  bits_t *vb;
+  unsigned int r;
+  unsigned int m;
+  unsigned int k;
+  unsigned int i;
+  unsigned int j;
+  unsigned int l;
+
+  vb = blds->u;
+  bitsClr(vb);
+  for (i = 0; i < vals->n; ++i)
+    bitsSet(vb, (*(vals->v + i))->id);
+  for (r = i = 0; i < infs->n; i = j) {
+    for (m = ~0U, j = i; j < infs->n && (inf = *(infs->v + j))->val == (*(infs->v + i))->val; ++j) {
+      if (!inf->ind)
+        k = 0;
+      else if (!blds->cst)
+        k = bitsAndCnt(inf->vb, vb);
+      else
+        for (k = l = 0; l < inf->vals->n; ++l)
+          if (bitsTst(vb, (*(inf->vals->v + l))->id))
+            k += (*(inf->vals->v + l))->cst;
+      if (k < m)
+        m = k;
+    }
+    if (m > r)
+      r = m;
+  }
+  return (r);
+}
+
+/* set to nodStpTo by SIGALRM (-t) or SIGINT, nodBld then keeps the best so */
+/* far and takes the first candidate where there is none yet, or with 2 gives up */
+static volatile sig_atomic_t nodStp;
+static sig_atomic_t nodStpTo = 1;
+
+static void
+nodStpSig(
+  int s
+){
+  (void)s;
+  nodStp = nodStpTo;
+}
+
+static const nod_t *nodBld(blds_t *, const vals_t *, const infs_t *, unsigned int, unsigned int, unsigned int);
+
+/* build the candidate node testing val, *n is 0 when val is not a candidate */
+/* or when its d can not be at most c */
+/* with -s the O branch of nod goes on with its switch */
+static int
+nodSwt(
+  const blds_t *blds
+ ,const nod_t *nod
+){
+  return (blds->s
+   && !nod->infsO
+   && nod->nodO
+   && nod->nodO->val
+   && nod->nodO->val->nam == nod->val->nam);
+}
+
+static int
+nodBldVal(
+  blds_t *blds
+ ,const vals_t *vals
+ ,const infs_t *infs
+ ,const val_t *val
+ ,const bits_t *vb
+ ,unsigned int bd
+ ,unsigned int c
+ ,unsigned int q
+ ,nod_t **n
+){
+  nod_t *r;
+  infs_t *nV;
+  infs_t *nO;
+  vals_t *fV;
+  vals_t *fO;
+  double x;
+  double p;
+  unsigned int j;
+
+#if DTC_DEBUG
+printf("I %.*s %.*s\n",val->nam->sym->n,val->nam->sym->v,val->sym->n,val->sym->v);
+nodInfsPrt(val->infs);
+#endif
+
+  *n = 0;
+  if (!(r = areClc(&blds->scr, sizeof (*r))))
+    return (1);
+
+  if (!(nV = infsResVal(&blds->scr, vb, infs, val, infs->n))
+   || !(nO = infsResValNam(&blds->scr, vb, infs, val)))
+    return (1);
+
+#if DTC_DEBUG
+puts("infsV");
+nodInfsPrt(nV);
+puts("infsO");
+nodInfsPrt(nO);
+#endif
+
+  /* the closure from one of them takes in the vals of all */
+  if (nV->n) {
+    if (infsValTrnAdd(&blds->scr, (*nV->v)->val, infs, vb, nV))
+      return (1);
+    r->infsV = nV;
+#if DTC_DEBUG
+puts("infsV");
+nodInfsPrt(r->infsV);
+#endif
+  }
+
+  if (nO->n) {
+    if (infsValTrnAdd(&blds->scr, (*nO->v)->val, infs, vb, nO))
+      return (1);
+    r->infsO = nO;
+#if DTC_DEBUG
+puts("infsO");
+nodInfsPrt(r->infsO);
+#endif
+  }
+
+  if (!(nV = infsMnsInfs(&blds->scr, infs, val->ob))
+   || !(nO = infsMnsInfs(&blds->scr, infs, val->ib)))
+    return (1);
+
+#if DTC_DEBUG
+puts("nV");
+nodInfsPrt(nV);
+puts("nO");
+nodInfsPrt(nO);
+#endif
+
+  if (nV->n && r->infsV) {
+    if (!(nV = infsSrpInfs(&blds->scr, nV, r->infsV, blds->rv, blds->cv)))
+      return (1);
+#if DTC_DEBUG
+puts("nV");
+nodInfsPrt(nV);
+#endif
+  }
+
+  if (nO->n && r->infsO) {
+    if (!(nO = infsSrpInfs(&blds->scr, nO, r->infsO, blds->rv, blds->cv)))
+      return (1);
+#if DTC_DEBUG
+puts("nO");
+nodInfsPrt(nO);
+#endif
+  }
+
+  fV = fO = 0;
+  if (nV->n && !(fV = valsSubValNam(&blds->scr, vals, val, nV, blds->u)))
+    return (1);
+  if (nO->n && !(fO = valsSubVal(&blds->scr, vals, val, nO, blds->u)))
+    return (1);
+
+#if DTC_DEBUG
+puts("fV");
+nodValsPrt(fV);
+puts("fO");
+nodValsPrt(fO);
+#endif
+
+  /* with -s the O branch may go on with the same switch, at the same d */
+  if ((fV && !fV->n)
+   || (fO && !fO->n)
+   || ((fV || (fO && !blds->s)) && !c)) {
+#if DTC_DEBUG
+puts("!fV || !fO || !c");
+#endif
+    return (0);
+  }
+
+  r->val = val;
+
+#if DTC_DEBUG
+puts("V");
+#endif
+  if (fV && !(r->nodV = nodBld(blds, fV, nV, bd, c - 1, q)))
+    return (1);
+
+#if DTC_DEBUG
+puts("O");
+#endif
+  if (fO && r->nodV != &nodCut) {
+    /* bldsEvc may move r->nodV under it */
+    if (blds->lim && bldsRt(blds, &r->nodV))
+      return (1);
+    *(blds->xv->v + blds->xv->n++) = val;
+    r->nodO = nodBld(blds, fO, nO, bd, blds->s ? c : c - 1, q);
+    --blds->xv->n;
+    if (blds->lim)
+      --blds->rn;
+    if (!r->nodO)
+      return (1);
+  }
+
+  if (r->nodV || r->nodO) {
+    if (r->nodV && r->nodO && r->nodV->val && r->nodO->val)
+      r->d = 1 + (r->nodV->d > r->nodO->d ? r->nodV->d : r->nodO->d);
+    else if (!r->nodO && r->nodV && r->nodV->val)
+      r->d = 1 + r->nodV->d;
+    else if (!r->nodV && r->nodO && r->nodO->val)
+      r->d = 1 + r->nodO->d;
+    else
+      return (0);
+  }
+  /* d is the cst of the longest path less one */
+  r->d += val->cst - 1;
+  /* the test is true with the p of val given the vals of its nam tested false on the way */
+  for (x = 0, j = 0; j < blds->xv->n; ++j)
+    if ((*(blds->xv->v + j))->nam == val->nam)
+      x += (*(blds->xv->v + j))->p;
+  p = x < 1 && val->p < 1 - x ? val->p / (1 - x) : 1;
+  r->e = val->cst
+   + (r->nodV ? p * r->nodV->e : 0)
+   + (r->nodO ? (1 - p) * r->nodO->e : 0);
+  /* with -s an O branch testing the same nam is the same switch, its cst is paid there */
+  if (nodSwt(blds, r)) {
+    r->d = r->nodV ? val->cst + r->nodV->d : 0;
+    if (r->d < r->nodO->d)
+      r->d = r->nodO->d;
+    r->e = p * (val->cst + (r->nodV ? r->nodV->e : 0)) + (1 - p) * r->nodO->e;
+  }
+  *n = r;
   return (0);
 }
 
-static const bld_t *
-bldsAdd(
+/* with -e the vals of xv of the nams in vals, in valCmp order (in scratch), u is scratch */
+static vals_t *
+nodBldX(
   blds_t *blds
- ,bld_t *bld
+ ,const vals_t *vals
 ){
-  void *v;
-  unsigned int lo;
-  unsigned int hi;
-  unsigned int mid;
-  int c;
+  vals_t *r;
+  const nam_t *nam;
+  unsigned int i;
+  unsigned int j;
 
-  if (!bld || !blds)
+  if (!(r = valsAre(&blds->scr, blds->xv->n)))
     return (0);
-  /* binary search for insertion position - O(n) vs qsort O(n log n) */
-  lo = 0;
-  hi = blds->n;
-  while (lo < hi) {
-    mid = lo + (hi - lo) / 2;
-    c = bldsSrtCmp((const bld_t **)&bld, (const bld_t **)(blds->v + mid));
-    if (c < 0)
-      hi = mid;
-    else
-      lo = mid + 1;
+  bitsClr(blds->u);
+  for (i = 0; i < vals->n; ++i)
+    bitsSet(blds->u, (*(vals->v + i))->id);
+  for (i = 0; i < blds->xv->n; ++i) {
+    nam = (*(blds->xv->v + i))->nam;
+    for (j = 0; j < nam->vals->n && !bitsTst(blds->u, (*(nam->vals->v + j))->id); ++j);
+    if (j < nam->vals->n)
+      *(r->v + r->n++) = *(blds->xv->v + i);
   }
-  if (!(v = realloc(blds->v, (blds->n + 1) * sizeof (*blds->v))))
-    return (0);
-  blds->v = v;
-  if (lo < blds->n)
-    memmove(blds->v + lo + 1, blds->v + lo, (blds->n - lo) * sizeof (*blds->v));
-  *(blds->v + lo) = bld;
-  ++blds->n;
-  return (bld);
-#if 0 /* original qsort technique - O(n log n) per insert */
-  if (!bld || !blds)
+  qsort(r->v, r->n, sizeof (*r->v), (int(*)(const void *, const void *))valsSrtCmp);
+  return (r);
+}
+
+/* new bld (in the memo) with the candidate vals sorted and the bits of vals (in scratch) */
+static bld_t *
+nodBldNew(
+  blds_t *blds
+ ,const vals_t *vals
+ ,const infs_t *infs
+ ,unsigned int c
+ ,const vals_t *x
+ ,unsigned long h
+ ,vals_t **vs
+ ,bits_t **vb
+){
+  bld_t *bld;
+  unsigned int i;
+
+  /* with --memo-limit or -j it is in are only when finished, nodBldAdd copies it */
+  if (!(bld = bldAre(blds->lim || blds->shr ? &blds->scr : &blds->are, &blds->nds, vals, infs, h))
+   || !(*vs = valsAreDup(&blds->scr, vals))
+   || !(*vb = bitsAre(&blds->scr, blds->vn)))
     return (0);
-  if (!(v = realloc(blds->v, (blds->n + 1) * sizeof (*blds->v))))
+  bld->c = c;
+  if (x && !(bld->x = valsAreDup(blds->lim || blds->shr ? &blds->scr : &blds->are, x)))
     return (0);
-  blds->v = v;
-  *(blds->v + blds->n++) = bld;
-  qsort(blds->v, blds->n, sizeof (*blds->v), (int(*)(const void *, const void *))bldsSrtCmp);
+  for (i = 0; i < vals->n; ++i)
+    bitsSet(*vb, (*(vals->v + i))->id);
+  qsort((*vs)->v, (*vs)->n, sizeof (*(*vs)->v), (int(*)(const void *, const void *))valsInfsCmp);
   return (bld);
-#endif
 }
 
-#if DTC_DEBUG
-static void
-bldsPrt(
+/* r is better than n, by d or with -e by e then d */
+static int
+nodBtr(
   const blds_t *blds
+ ,const nod_t *r
+ ,const nod_t *n
 ){
-  unsigned int i;
+  if (blds->e && r->e != n->e)
+    return (r->e < n->e);
+  return (r->d < n->d);
+}
 
-  if (!blds)
-    return;
-  puts("blds(");
-  for (i = 0; i < blds->n; ++i)
-    bldPrt(*(blds->v + i));
-  puts(")");
+/* add the finished bld, with the unresolved infs when there is no val */
+static const nod_t *
+nodBldAdd(
+  blds_t *blds
+ ,bld_t *bld
+ ,const infs_t *infs
+){
+  if (!bld->nod->val) {
+    if (!(bld->nod->infsV = infsAreDup(&blds->nds, infs)))
+      return (0);
+#if DTC_DEBUG
+puts("!val");
+nodInfsPrt(infs);
+#endif
+  }
+#if DTC_PTHREAD
+  if (blds->shr)
+    return (bldsShrAdd(blds, bld));
+#endif
+  if (blds->lim && !(bld = bldDup(&blds->are, bld)))
+    return (0);
+  if (!bldsAdd(blds, bld))
+    return (0);
+  return (bld->nod);
 }
+
+/* c is the largest d of use to the caller */
+static const nod_t *
+nodBld(
+  blds_t *blds
+ ,const vals_t *vals
+ ,const infs_t *infs
+ ,unsigned int bd
+ ,unsigned int c
+ ,unsigned int q
+){
+  bld_t *bld;
+  vals_t *vs;
+  vals_t *x;
+  bits_t *vb;
+  nod_t *r;
+  const nod_t *n;
+  areMrk_t m;
+  areMrk_t mi;
+  unsigned long h;
+  unsigned long xs;
+  unsigned int i;
+
+#if DTC_DEBUG
+printf("B %u %u %u\n",vals->n,infs->n,bd);
+nodValsPrt(vals);
+nodInfsPrt(infs);
+#endif
+  /* with -e the best under a bound is not the best under a smaller one */
+  /* and the p of a test depends on the vals of its nam tested false before */
+  /* a path tests each val at most once, so a larger c is the same search */
+  if (blds->e && vals->n && c > (i = blds->cst ? valsCst(vals) : vals->n) - 1)
+    c = i - 1;
+  m = areMrk(&blds->scr);
+  x = 0;
+  if (blds->e && !(x = nodBldX(blds, vals)))
+    goto error;
+  h = bldHsh(vals, infs, blds->e ? c + 1 : 0, x);
+  if ((bld = bldsFnd(blds, vals, infs, blds->e ? c + 1 : 0, x, h))) {
+#if DTC_DEBUG
+    printf("cache %s %u\n", bld->nod->val ? "val" : "!val", bld->nod->d);
+#endif
+    ++blds->sts.hit;
+    if (blds->lim && bld->u < ~0U)
+      ++bld->u;
+    areRst(&blds->scr, m);
+    return (bld->nod);
+  }
+#if DTC_PTHREAD
+  if (blds->shr && (n = bldsShrFnd(blds, vals, infs, blds->e ? c + 1 : 0, x, h, bd))) {
+    ++blds->sts.hit;
+    areRst(&blds->scr, m);
+    return (n);
+  }
 #endif
+  ++blds->sts.mis;
+  if (nodLb(blds, vals, infs) > c + 1) {
+#if DTC_DEBUG
+    printf("cut %u\n", c);
+#endif
+    ++blds->sts.cut;
+    areRst(&blds->scr, m);
+    return (&nodCut);
+  }
+  if (cchFnd(blds, vals, infs, &n))
+    goto error;
+  if (n) {
+    ++blds->sts.cch;
+    areRst(&blds->scr, m);
+    return (n);
+  }
+  if (!(bld = nodBldNew(blds, vals, infs, blds->e ? c + 1 : 0, x, h, &vs, &vb)))
+    goto error;
+  ++*(blds->sts.exp + blds->l);
+  xs = blds->xn++;
+  if (blds->lim && bldsRt(blds, (const nod_t **)&bld->nod))
+    goto error;
+
+  /* a candidate is built in scratch and only copied to the memo when it is better */
+  for (i = 0; i < vs->n && !(nodStp && (bld->nod->val || nodStp > 1)); ++i) {
+    if (valsEqPrv(vs, i) || valsTwoPrv(vs, vb, i))
+      continue;
+    mi = areMrk(&blds->scr);
+    ++blds->l;
+    /* with -e a deeper candidate may be better, c stays the bound (of the memo key) */
+    if (nodBldVal(blds, vals, infs, *(vs->v + i), vb, bd
+     ,blds->e ? c : bld->nod->val ? bld->nod->d - 1 : bd, q, &r)) {
+      --blds->l;
+      goto error;
+    }
+    --blds->l;
+    if (!r) {
+      areRst(&blds->scr, mi);
+      continue;
+    }
+    ++*(blds->sts.cnd + blds->l);
+    if (r->d > (blds->e ? c : bd)) {
+#if DTC_DEBUG
+printf("not better %u > %u\n", r->d, bd);
+#endif
+      ++*(blds->sts.prn + blds->l);
+      areRst(&blds->scr, mi);
+      continue;
+    }
+    if (!bld->nod->val || nodBtr(blds, r, bld->nod)) {
+      if (nodCpy(&blds->nds, bld->nod, r))
+        goto error;
+      areRst(&blds->scr, mi);
+      if (q || !bld->nod->d)
+        break;
+      if (!blds->e)
+        bd = bld->nod->d;
+    } else
+      areRst(&blds->scr, mi);
+  }
+  bld->w = blds->xn - xs < ~0U ? blds->xn - xs : ~0U;
+  if (blds->lim)
+    --blds->rn;
+  /* without a val it says there is none under bd, which is still the one of the call */
+  bld->b = bd;
+  if (!(n = nodBldAdd(blds, bld, infs))
+   || (blds->lim && bldsSz(blds) > blds->gc && bldsEvc(blds, &n)))
+    goto error;
+  areRst(&blds->scr, m);
+  return (n);
+error:
+  areRst(&blds->scr, m);
+  return (0);
+}
+
+#if DTC_PTHREAD
+/*
+ * Parallel search of the top level candidates.
+ * The threads share the memo (bldsShrFnd) and the bound: a candidate is built under the d of the best earlier one less one,
+ * and up to the d of the best later one, as a tie goes to the earlier. The
+ * nodBld loop finds the same d and the same node with its tighter bounds, so
+ * finished candidates are reduced in candidate order with the same rules as
+ * it (and the same early stop), and the result does not depend on
+ * scheduling. With --memo-limit bldsEvc moves the nodes of a memo, so each
+ * candidate is built with a memo of its own and only the bound is shared.
+ */
+typedef struct par par_t;
+
+struct par {
+  pthread_mutex_t m;
+  pthread_rwlock_t l; /* of blds when it is shared */
+  blds_t *blds;
+  const vals_t *vals;
+  const infs_t *infs;
+  const vals_t *vs;
+  const bits_t *vb;
+  struct {
+    blds_t *blds; /* with --memo-limit its own memo, else 0 */
+    nod_t *nod; /* in the memo of blds, else in P->blds */
+    unsigned int d; /* of nod, ~0U for none */
+    int s; /* 0 pending, 1 built, 2 failed */
+  } *c;
+  blds_t **w; /* without --memo-limit the memo of each thread, its blds->shr is blds */
+  unsigned int wn;
+  unsigned int wi; /* next w to take */
+  bld_t *bld;
+  blds_t *nodBlds; /* memo of bld->nod */
+  unsigned int bd;
+  unsigned int bd0; /* initial bound */
+  unsigned int q;
+  unsigned int i; /* next candidate to build */
+  unsigned int j; /* next candidate to reduce */
+  unsigned int x; /* candidates at and after are not needed */
+  int err;
+};
 
+/* reduce candidate P->j (called with P->m locked) */
 static void
-bldsFre(
-  blds_t *blds
+parRed(
+  par_t *p
 ){
-  if (!blds)
-    return;
-  while (blds->n--)
-    bldFre(*(blds->v + blds->n));
-  free(blds->v);
-  free(blds);
+  nod_t *r;
+
+  r = (p->c + p->j)->nod;
+  (p->c + p->j)->nod = 0;
+  if ((p->c + p->j)->blds)
+    bldsSts(p->blds, (p->c + p->j)->blds);
+  if (r) {
+    ++*(p->blds->sts.cnd);
+    if (r->d > p->bd)
+      ++*(p->blds->sts.prn);
+  }
+  if ((p->c + p->j)->s == 2) {
+    p->err = 1;
+    p->x = p->j;
+  } else if (r && r->d <= p->bd
+   && (!p->bld->nod->val || nodBtr(p->blds, r, p->bld->nod))) {
+    bldsFre(p->nodBlds);
+    p->bld->nod = r;
+    p->nodBlds = (p->c + p->j)->blds;
+    (p->c + p->j)->blds = 0;
+    if (p->q || !r->d)
+      p->x = p->j + 1;
+    else if (!p->blds->e)
+      p->bd = r->d;
+  }
+  bldsFre((p->c + p->j)->blds);
+  (p->c + p->j)->blds = 0;
+  ++p->j;
+}
+
+/*
+ * the bound of candidate i (called with P->m locked), ~0U when an earlier one
+ * has a d of 0
+ */
+static unsigned int
+parBd(
+  const par_t *p
+ ,unsigned int i
+){
+  unsigned int b;
+  unsigned int k;
+
+  /* -q and -e keep the initial bound, as the nodBld loop does */
+  b = p->bd0;
+  if (p->q || p->blds->e)
+    return (b);
+  for (k = 0; k < p->vs->n; ++k)
+    if ((p->c + k)->d == ~0U || k == i)
+      continue;
+    else if (k < i) {
+      if (!(p->c + k)->d)
+        return (~0U);
+      if ((p->c + k)->d - 1 < b)
+        b = (p->c + k)->d - 1;
+    } else if ((p->c + k)->d < b)
+      b = (p->c + k)->d;
+  return (b);
 }
 
+static void *
+parWrk(
+  void *v
+){
+#define P ((par_t *)v)
+  blds_t *w;
+  blds_t *b;
+  nod_t *r;
+  nod_t *t;
+  areMrk_t m;
+  unsigned int bd;
+  unsigned int i;
+  int s;
+
+  pthread_mutex_lock(&P->m);
+  w = P->wi < P->wn ? *(P->w + P->wi++) : 0;
+  pthread_mutex_unlock(&P->m);
+  for (;;) {
+    pthread_mutex_lock(&P->m);
+    if (nodStp && P->bld->nod->val && P->i < P->x)
+      P->x = P->i;
+    if ((i = P->i) >= P->x) {
+      pthread_mutex_unlock(&P->m);
+      break;
+    }
+    ++P->i;
+    bd = parBd(P, i);
+    pthread_mutex_unlock(&P->m);
+    r = 0;
+    b = 0;
+    if (bd == ~0U || valsEqPrv(P->vs, i) || valsTwoPrv(P->vs, P->vb, i))
+      s = 1;
+    else {
+      if (w)
+        b = w;
+      else if ((b = bldsNew(P->blds->vn))) {
+        b->cch = P->blds->cch;
+        b->e = P->blds->e;
+        b->cst = P->blds->cst;
+        b->s = P->blds->s;
+        bldsLim(b, P->blds->lim);
+        b->l = 1;
+      }
+      s = 2;
+      if (b) {
+        m = areMrk(&b->scr);
+        if (!nodBldVal(b, P->vals, P->infs, *(P->vs->v + i), P->vb, bd, bd, P->q, &t))
+          s = 1;
+        /* the candidate is kept in the memo it refers to */
+        if (s == 1 && t && w) {
+          pthread_rwlock_wrlock(&P->l);
+          if (!(r = areAlc(&P->blds->nds, sizeof (*r))) || nodCpy(&P->blds->nds, r, t))
+            s = 2;
+          pthread_rwlock_unlock(&P->l);
+        } else if (s == 1 && t && (!(r = areAlc(&b->nds, sizeof (*r))) || nodCpy(&b->nds, r, t)))
+          s = 2;
+        areRst(&b->scr, m);
+      }
+      if (w)
+        b = 0;
+    }
+    pthread_mutex_lock(&P->m);
+    (P->c + i)->blds = b;
+    (P->c + i)->nod = r;
+    (P->c + i)->d = r ? r->d : ~0U;
+    (P->c + i)->s = s;
+    while (P->j < P->x && (P->c + P->j)->s)
+      parRed(P);
+    pthread_mutex_unlock(&P->m);
+  }
+  return (0);
+#undef P
+}
+
+/* nodBld of the top level with the candidates spread over j threads */
 static const nod_t *
-nodBld(
+nodBldPar(
   blds_t *blds
  ,const vals_t *vals
  ,const infs_t *infs
  ,unsigned int bd
  ,unsigned int q
+ ,unsigned int j
 ){
-  bld_t *bld;
+  par_t p;
+  pthread_t *t;
   vals_t *vs;
-  nod_t *r;
-  infs_t *nV;
-  infs_t *nO;
-  vals_t *fV;
-  vals_t *fO;
-  infs_t *d;
+  vals_t *x;
+  bits_t *vb;
+  const nod_t *n;
+  areMrk_t m;
   unsigned int i;
-  unsigned int j;
+  unsigned int k;
+  int l;
 
-#if DTC_DEBUG
-printf("B %u %u %u\n",vals->n,infs->n,bd);
-nodValsPrt(vals);
-nodInfsPrt(infs);
+  memset(&p, 0, sizeof (p));
+  t = 0;
+  l = 1;
+  m = areMrk(&blds->scr);
+  ++blds->sts.mis;
+  if (!blds->lim
+   && (!(p.w = calloc(j, sizeof (*p.w)))
+    || (l = pthread_rwlock_init(&p.l, 0))))
+    goto error;
+  for (; p.w && p.wn < j; ++p.wn) {
+    if (!(*(p.w + p.wn) = bldsNew(blds->vn)))
+      goto error;
+    (*(p.w + p.wn))->cch = blds->cch;
+    (*(p.w + p.wn))->e = blds->e;
+    (*(p.w + p.wn))->cst = blds->cst;
+    (*(p.w + p.wn))->s = blds->s;
+    (*(p.w + p.wn))->l = 1;
+    (*(p.w + p.wn))->shr = blds;
+    (*(p.w + p.wn))->shl = &p.l;
+  }
+  /* nothing is tested false at the top */
+  x = 0;
+  if ((blds->e && !(x = nodBldX(blds, vals)))
+   || !(p.bld = nodBldNew(blds, vals, infs, blds->e ? bd + 1 : 0, x
+   ,bldHsh(vals, infs, blds->e ? bd + 1 : 0, x), &vs, &vb))
+   || !(p.c = calloc(vs->n ? vs->n : 1, sizeof (*p.c)))
+   || !(t = calloc(j, sizeof (*t)))
+   || pthread_mutex_init(&p.m, 0))
+    goto error;
+  for (k = 0; k < vs->n; ++k)
+    (p.c + k)->d = ~0U;
+  p.blds = blds;
+  p.vals = vals;
+  p.infs = infs;
+  p.vs = vs;
+  p.vb = vb;
+  p.bd = p.bd0 = bd;
+  p.q = q;
+  p.x = vs->n;
+  ++*blds->sts.exp;
+  for (i = 0; i < j && !pthread_create(t + i, 0, parWrk, &p); ++i);
+  if (!i)
+    parWrk(&p);
+  for (k = 0; k < i; ++k)
+    pthread_join(*(t + k), 0);
+  pthread_mutex_destroy(&p.m);
+  /* built after the stop */
+  for (k = p.x; k < vs->n; ++k) {
+    if ((p.c + k)->blds)
+      bldsSts(blds, (p.c + k)->blds);
+    bldsFre((p.c + k)->blds);
+  }
+  /* the memo of the result joins blds */
+  if (p.nodBlds) {
+    if (bldsMov(blds, p.nodBlds))
+      p.err = 1;
+    bldsFre(p.nodBlds);
+  }
+  /* p.bld is in scr with --memo-limit */
+  n = p.err ? 0 : nodBldAdd(blds, p.bld, infs);
+  goto exit;
+error:
+  n = 0;
+exit:
+  /* what a thread memoized is in blds, only its counts are kept */
+  for (k = 0; k < p.wn; ++k) {
+    bldsSts(blds, *(p.w + k));
+    bldsFre(*(p.w + k));
+  }
+  if (!l)
+    pthread_rwlock_destroy(&p.l);
+  free(p.w);
+  free(p.c);
+  free(t);
+  areRst(&blds->scr, m);
+  return (n);
+}
 #endif
-  if ((bld = bldsFnd(blds, vals, infs))) {
-#if DTC_DEBUG
-    printf("cache %s %u\n", bld->nod->val ? "val" : "!val", bld->nod->d);
+
+/* top level build, with it deepening from the lower bound with a new memo each time */
+/* t is the number of threads, the memo of the result joins blds */
+static const nod_t *
+nodBldTop(
+  blds_t *blds
+ ,const vals_t *vals
+ ,const infs_t *infs
+ ,unsigned int it
+ ,unsigned int q
+ ,unsigned int t
+){
+  blds_t *d;
+  const nod_t *nod;
+  unsigned int b;
+  unsigned int n;
+
+  n = valsCst(vals);
+  b = n;
+  if (it && (b = nodLb(blds, vals, infs)))
+    --b;
+  for (nod = 0;; ++b) {
+    /* a stopped -i gives up the depth it was at for a quick search at the old bound */
+    if (nodStp)
+      nodStp = 1, b = n;
+    if (!it)
+      d = blds;
+    else if (!(d = bldsNew(blds->vn)))
+      return (0);
+    d->cch = blds->cch;
+    d->e = blds->e;
+    d->cst = blds->cst;
+    d->s = blds->s;
+    bldsLim(d, blds->lim);
+#if DTC_PTHREAD
+    if (!(nod = t > 1
+      ? nodBldPar(d, vals, infs, b, q, t)
+      : nodBld(d, vals, infs, b, b, q))
+#else
+    (void)t;
+    if (!(nod = nodBld(d, vals, infs, b, b, q))
 #endif
-    return (bld->nod);
+     || nod->val
+     || b >= n)
+      break;
+    bldsSts(blds, d);
+    bldsFre(d);
   }
-  if (!(bld = bldNew(vals, infs))
-   || !(bld->nod = nodNew())
-   || !(vs = valsRefDup(vals))) {
-    bldFre(bld);
-    return (0);
+  if (d != blds) {
+    bldsOvr(d);
+    bldsSts(blds, d);
+    if (nod && bldsMov(blds, d))
+      nod = 0;
+    bldsFre(d);
   }
-  qsort(vs->v, vs->n, sizeof (*vs->v), (int(*)(const void *, const void *))valsInfsCmp);
+  bldsOvr(blds);
+  return (nod);
+}
 
-  for (i = 0; i < vs->n; ++i) {
-#if DTC_DEBUG
-printf("I %u %.*s %.*s\n",i,(*(vs->v + i))->nam->sym->n,(*(vs->v + i))->nam->sym->v,(*(vs->v + i))->sym->n,(*(vs->v + i))->sym->v);
-nodInfsPrt((*(vs->v + i))->infs);
-#endif
+/********************************************************************************/
 
-    if (!(r = nodNew()))
-      goto error3;
+/* output buffer size, stdout is written in chunks of it */
+#define OUT_BUF (1 << 16)
 
-    nO = 0;
-    if (!(nV = infsResVal(vals, infs, *(vs->v + i)))
-     || !(nO = infsResValNam(vals, infs, *(vs->v + i))))
-      goto error2;
+/* output "o,nam,val" without the newline */
+static void
+outSym(
+  const char *o
+ ,const val_t *val
+){
+  fputs(o, stdout);
+  putchar(',');
+  fwrite(val->nam->sym->e, 1, val->nam->sym->en, stdout);
+  putchar(',');
+  fwrite(val->sym->e, 1, val->sym->en, stdout);
+}
 
-#if DTC_DEBUG
-puts("infsV");
-nodInfsPrt(nV);
-puts("infsO");
-nodInfsPrt(nO);
-#endif
+/* output "o,u\n" */
+static void
+outNum(
+  const char *o
+ ,unsigned int u
+){
+  char b[sizeof (u) * 3 + 3];
+  unsigned int i;
 
-    if (nV->n) {
-      for (j = 0; j < nV->n; ++j)
-        if (infsValTrnAdd((*(nV->v + j))->val, infs, vals, nV))
-          goto error2;
-      r->infsV = nV;
-#if DTC_DEBUG
-puts("infsV");
-nodInfsPrt(r->infsV);
-#endif
-    } else
-      infsRefFre(nV);
-    nV = 0;
-
-    if (nO->n) {
-      for (j = 0; j < nO->n; ++j)
-        if (infsValTrnAdd((*(nO->v + j))->val, infs, vals, nO))
-          goto error2;
-      r->infsO = nO;
-#if DTC_DEBUG
-puts("infsO");
-nodInfsPrt(r->infsO);
-#endif
-    } else
-      infsRefFre(nO);
-    nO = 0;
+  i = sizeof (b);
+  b[--i] = '\n';
+  do
+    b[--i] = '0' + u % 10;
+  while (u /= 10);
+  b[--i] = ',';
+  fputs(o, stdout);
+  fwrite(b + i, 1, sizeof (b) - i, stdout);
+}
 
-    for (d = 0, j = 0; j < (*(vs->v + i))->nam->vals->n; ++j) {
-      if (*((*(vs->v + i))->nam->vals->v + j) == *(vs->v + i))
-        continue;
-      if (!(nV = infsMnsInfs(d ? d : infs, (*((*(vs->v + i))->nam->vals->v + j))->infs))) {
-        infsRefFre(d);
-        goto error2;
-      }
-      infsRefFre(d);
-      d = nV;
-    }
-    if (!nV)
-      goto error2;
+/* output state */
+typedef struct out out_t;
 
-    if (!(nO = infsMnsInfs(infs, (*(vs->v + i))->infs)))
-      goto error2;
+struct out {
+  struct {
+    const infs_t *i;
+    const nod_t *n;
+    unsigned long h; /* outHsh of i, n and c */
+    unsigned int c;
+    unsigned int l;
+  } *b;
+  unsigned int n;
+  unsigned int a; /* allocated b */
+  unsigned int *h; /* open addressed index of b, entry + 1 */
+  unsigned int m;
+  unsigned int l;
+  const nod_t **c; /* roots of the independent subproblems, the end of one goes on to the next */
+  unsigned int cn;
+  unsigned int ci; /* of the nod being output */
+  const blds_t *blds; /* -s is of it */
+  struct {
+    const val_t *v;
+    unsigned int l;
+    int o;
+  } *o; /* -o c: the pseudocode lines, for outC */
+  unsigned int on;
+  unsigned int oa; /* allocated o */
+  unsigned int oc; /* -o c: lines go to o instead of stdout */
+  unsigned int oe; /* -o c: o out of memory */
+};
 
-#if DTC_DEBUG
-puts("nV");
-nodInfsPrt(nV);
-puts("nO");
-nodInfsPrt(nO);
-#endif
+/* compare infs by result values */
+static int
+outCmp(
+  const infs_t *a
+ ,const infs_t *b
+){
+  unsigned int i;
 
-    if (nV->n && r->infsV) {
-      d = infsSrpInfs(nV, r->infsV);
-      if (!d)
-        goto error2;
-      infsRefFre(nV);
-      nV = d;
-#if DTC_DEBUG
-puts("nV");
-nodInfsPrt(nV);
-#endif
-    }
+  if (!a && !b)
+    return (0);
+  if (!a || !b || a->n != b->n)
+    return (1);
+  for (i = 0; i < a->n; ++i)
+    if (valCmp((*(a->v + i))->val, (*(b->v + i))->val))
+      return (1);
+  return (0);
+}
 
-    if (nO->n && r->infsO) {
-      d = infsSrpInfs(nO, r->infsO);
-      if (!d)
-        goto error2;
-      infsRefFre(nO);
-      nO = d;
-#if DTC_DEBUG
-puts("nO");
-nodInfsPrt(nO);
-#endif
+static void outNod(out_t *, const nod_t *);
+static int outSwt(out_t *, const nod_t *);
+
+/* output the pseudocode line o with what of val and l it has, or with -o c add it to out->o */
+static void
+outLin(
+  out_t *out
+ ,int o
+ ,const val_t *val
+ ,unsigned int l
+){
+  char b[2];
+  void *v;
+
+  if (out->oc) {
+    if (out->on == out->oa) {
+      if (out->oe
+       || out->oa * 2 < out->oa
+       || !(v = realloc(out->o, (out->oa ? out->oa * 2 : 1024) * sizeof (*out->o)))) {
+        out->oe = 1;
+        return;
+      }
+      out->o = v;
+      out->oa = out->oa ? out->oa * 2 : 1024;
     }
+    (out->o + out->on)->v = val;
+    (out->o + out->on)->l = l;
+    (out->o + out->on)->o = o;
+    ++out->on;
+    return;
+  }
+  b[0] = o;
+  b[1] = '\0';
+  switch (o) {
+  case 'S':
+    printf("S,");
+    fwrite(val->nam->sym->e, 1, val->nam->sym->en, stdout);
+    putchar('\n');
+    break;
+  case 'R':
+    outSym(b, val);
+    putchar('\n');
+    break;
+  case 'T':
+  case 'C':
+    outSym(b, val);
+    outNum("", l);
+    break;
+  default:
+    outNum(b, l);
+    break;
+  }
+}
 
-    fV = fO = 0;
-    if (nV->n && !(fV = valsSubValNam(vals, *(vs->v + i), nV)))
-      goto error1;
-    if (nO->n && !(fO = valsSubVal(vals, *(vs->v + i), nO)))
-      goto error1;
+/* end of a subproblem, go on to the next or exit */
+static void
+outNxt(
+  out_t *out
+){
+  if (out->ci + 1 < out->cn) {
+    ++out->ci;
+    outNod(out, *(out->c + out->ci));
+    --out->ci;
+  } else
+    outLin(out, 'J', 0, 0);
+}
 
-#if DTC_DEBUG
-puts("fV");
-nodValsPrt(fV);
-puts("fO");
-nodValsPrt(fO);
-#endif
+/* hash of a branch, consistent with outCmp */
+static unsigned long
+outHsh(
+  const infs_t *infs
+ ,const nod_t *nod
+ ,unsigned int c
+){
+  unsigned long h;
+  unsigned int i;
 
-    if ((fV && !fV->n)
-     || (fO && !fO->n)) {
-#if DTC_DEBUG
-puts("!fV || !fO");
-#endif
-      valsRefFre(fO);
-      valsRefFre(fV);
-      infsRefFre(nV);
-      infsRefFre(nO);
-      nodFre(r);
-      continue;
-    }
+  h = 2166136261UL;
+  h = (h ^ (unsigned long)nod) * 16777619UL;
+  h = (h ^ c) * 16777619UL;
+  if (infs) {
+    for (i = 0; i < infs->n; ++i)
+      h = (h ^ (*(infs->v + i))->val->nam->sym->h ^ (*(infs->v + i))->val->sym->h << 1) * 16777619UL;
+    h = (h ^ infs->n) * 16777619UL;
+  }
+  return (h ^ h >> 15);
+}
+
+/* double the index of out->b */
+static int
+outGrw(
+  out_t *out
+){
+  unsigned int *h;
+  unsigned int m;
+  unsigned int i;
+  unsigned int j;
 
-    r->val = *(vs->v + i);
+  m = out->m ? out->m * 2 : 256;
+  if (m < out->m
+   || !(h = calloc(m, sizeof (*h))))
+    return (1);
+  for (i = 0; i < out->n; ++i) {
+    for (j = (out->b + i)->h & (m - 1); *(h + j); j = (j + 1) & (m - 1));
+    *(h + j) = i + 1;
+  }
+  free(out->h);
+  out->h = h;
+  out->m = m;
+  return (0);
+}
 
-#if DTC_DEBUG
-puts("V");
-#endif
-    if (fV && !(r->nodV = nodBld(blds, fV, nV, bd, q)))
-      goto error1;
+/* find or reserve label for branch, set *dup if duplicate */
+static unsigned int
+outBrnLbl(
+  out_t *out
+ ,const infs_t *infs
+ ,const nod_t *nod
+ ,int *dup
+){
+  unsigned long h;
+  unsigned int i;
+  unsigned int j;
+  unsigned int l;
+  void *v;
 
-#if DTC_DEBUG
-puts("O");
-#endif
-    if (fO && !(r->nodO = nodBld(blds, fO, nO, bd, q)))
-      goto error1;
-
-    valsRefFre(fO);
-    valsRefFre(fV);
-    infsRefFre(nO);
-    infsRefFre(nV);
-
-    if (r->nodV || r->nodO) {
-      if (r->nodV && r->nodO && r->nodV->val && r->nodO->val)
-        r->d = 1 + (r->nodV->d > r->nodO->d ? r->nodV->d : r->nodO->d);
-      else if (!r->nodO && r->nodV && r->nodV->val)
-        r->d = 1 + r->nodV->d;
-      else if (!r->nodV && r->nodO && r->nodO->val)
-        r->d = 1 + r->nodO->d;
-      else {
-        nodFre(r);
-        continue;
+  h = outHsh(infs, nod, out->ci);
+  /* a failed grow leaves a fuller, still working, index */
+  if ((out->n + 1) * 2 > out->m)
+    outGrw(out);
+  j = 0;
+  if (out->n < out->m)
+    for (j = h & (out->m - 1); (i = *(out->h + j)); j = (j + 1) & (out->m - 1))
+      if ((out->b + i - 1)->h == h && (out->b + i - 1)->n == nod && (out->b + i - 1)->c == out->ci && !outCmp((out->b + i - 1)->i, infs)) {
+        *dup = 1;
+        return ((out->b + i - 1)->l);
       }
+  *dup = 0;
+  l = out->l++;
+  /* not recorded without a free index slot or room in b, only costs a duplicate */
+  if (out->n + 1 >= out->m)
+    return (l);
+  if (out->n == out->a) {
+    if (!(v = realloc(out->b, (out->a ? out->a * 2 : 256) * sizeof (*out->b))))
+      return (l);
+    out->b = v;
+    out->a = out->a ? out->a * 2 : 256;
+  }
+  (out->b + out->n)->i = infs;
+  (out->b + out->n)->n = nod;
+  (out->b + out->n)->h = h;
+  (out->b + out->n)->c = out->ci;
+  (out->b + out->n)->l = l;
+  *(out->h + j) = ++out->n;
+  return (l);
+#if 0 /* original linear scan - O(n) per branch */
+  unsigned int i;
+  void *v;
+
+  for (i = 0; i < out->n; ++i)
+    if ((out->b + i)->n == nod && (out->b + i)->c == out->ci && !outCmp((out->b + i)->i, infs)) {
+      *dup = 1;
+      return ((out->b + i)->l);
     }
-    if (r->d > bd) {
-#if DTC_DEBUG
-printf("not better %u > %u\n", r->d, bd);
-#endif
-      nodFre(r);
-      continue;
-    }
-    if (!bld->nod->val || r->d < bld->nod->d) {
-      nodFre(bld->nod);
-      bld->nod = r;
-      if (q || !bld->nod->d)
-        break;
-      bd = bld->nod->d;
-    } else
-      nodFre(r);
+  *dup = 0;
+  i = out->l++;
+  if ((v = realloc(out->b, (out->n + 1) * sizeof (*out->b)))) {
+    out->b = v;
+    (out->b + out->n)->i = infs;
+    (out->b + out->n)->n = nod;
+    (out->b + out->n)->c = out->ci;
+    (out->b + out->n)->l = i;
+    ++out->n;
   }
-  if (!bld->nod->val) {
-    if (!(bld->nod->infsV = infsRefDup(infs)))
-      goto error3;
-#if DTC_DEBUG
-puts("!val");
-nodInfsPrt(infs);
+  return (i);
 #endif
-  }
-  if (!bldsAdd(blds, bld))
-    goto error3;
-  valsRefFre(vs);
-  return (bld->nod);
-error1:
-  valsRefFre(fO);
-  valsRefFre(fV);
-error2:
-  infsRefFre(nO);
-  infsRefFre(nV);
-  nodFre(r);
-error3:
-  valsRefFre(vs);
-  bldFre(bld);
-  return (0);
 }
 
-/********************************************************************************/
-
-/* output state */
-typedef struct out out_t;
+/*
+ * Hash-consing of the nodes before output: the memo shares the nodes of the
+ * same (vals, infs), but other keys can still build nodes testing and
+ * resolving the same, each output on its own. Bottom up from each root, the
+ * children of a node are replaced by the first node found with the same val,
+ * result values and children, so outNod outputs them once. The subproblem
+ * (ci) is part of the key as a leaf goes on to the next root.
+ */
+struct outCanV {
+  const nod_t *n;
+  const nod_t *c; /* the node used for n */
+  unsigned int ci;
+};
 
-struct out {
-  struct {
-    const infs_t *i;
-    const nod_t *n;
-    unsigned int l;
-  } *b;
-  unsigned int n;
-  unsigned int l;
+struct outCanS {
+  const nod_t *n;
+  unsigned long h; /* outCanHsh */
+  unsigned int ci;
 };
 
-/* compare infs by result values */
+typedef struct {
+  struct outCanV *v; /* the nodes seen, open addressed by n and ci */
+  struct outCanS *s; /* the nodes used, open addressed by h */
+  unsigned int vn;
+  unsigned int vm;
+  unsigned int sn;
+  unsigned int sm;
+  unsigned int ci;
+  unsigned int e; /* out of memory, the rest is output as it is */
+} outCan_t;
+
+/* index hash of a node seen */
+static unsigned long
+outCanVHsh(
+  const nod_t *nod
+ ,unsigned int ci
+){
+  unsigned long h;
+
+  h = 2166136261UL;
+  h = (h ^ (unsigned long)nod) * 16777619UL;
+  h = (h ^ ci) * 16777619UL;
+  return (h ^ h >> 15);
+}
+
+/* hash of nod, consistent with outCanCmp */
+static unsigned long
+outCanHsh(
+  const nod_t *nod
+ ,unsigned int ci
+){
+  unsigned long h;
+
+  h = outHsh(nod->infsV, nod->nodV, ci);
+  h = (h ^ outHsh(nod->infsO, nod->nodO, ci)) * 16777619UL;
+  h = (h ^ (unsigned long)nod->val) * 16777619UL;
+  return (h ^ h >> 15);
+}
+
+/* same output, once the children are the nodes used */
+static int
+outCanCmp(
+  const nod_t *n1
+ ,const nod_t *n2
+){
+  return (n1->val != n2->val
+   || n1->nodV != n2->nodV
+   || n1->nodO != n2->nodO
+   || outCmp(n1->infsV, n2->infsV)
+   || outCmp(n1->infsO, n2->infsO));
+}
+
+/* double the index of the nodes seen */
+static int
+outCanVGrw(
+  outCan_t *can
+){
+  struct outCanV *v;
+  unsigned int m;
+  unsigned int i;
+  unsigned int j;
+
+  m = can->vm ? can->vm * 2 : 256;
+  if (m < can->vm
+   || !(v = calloc(m, sizeof (*v))))
+    return (1);
+  for (i = 0; i < can->vm; ++i)
+    if ((can->v + i)->n) {
+      for (j = outCanVHsh((can->v + i)->n, (can->v + i)->ci) & (m - 1); (v + j)->n; j = (j + 1) & (m - 1));
+      *(v + j) = *(can->v + i);
+    }
+  free(can->v);
+  can->v = v;
+  can->vm = m;
+  return (0);
+}
+
+/* double the index of the nodes used */
 static int
-outCmp(
-  const infs_t *a
- ,const infs_t *b
+outCanSGrw(
+  outCan_t *can
 ){
+  struct outCanS *s;
+  unsigned int m;
   unsigned int i;
+  unsigned int j;
 
-  if (!a && !b)
-    return (0);
-  if (!a || !b || a->n != b->n)
+  m = can->sm ? can->sm * 2 : 256;
+  if (m < can->sm
+   || !(s = calloc(m, sizeof (*s))))
     return (1);
-  for (i = 0; i < a->n; ++i)
-    if (valCmp((*(a->v + i))->val, (*(b->v + i))->val))
-      return (1);
+  for (i = 0; i < can->sm; ++i)
+    if ((can->s + i)->n) {
+      for (j = (can->s + i)->h & (m - 1); (s + j)->n; j = (j + 1) & (m - 1));
+      *(s + j) = *(can->s + i);
+    }
+  free(can->s);
+  can->s = s;
+  can->sm = m;
   return (0);
 }
 
-static void outNod(out_t *, const nod_t *);
-
-/* find or reserve label for branch, set *dup if duplicate */
-static unsigned int
-outBrnLbl(
-  out_t *out
- ,const infs_t *infs
+/* the node used for nod, its children replaced first */
+static const nod_t *
+outCanNod(
+  outCan_t *can
  ,const nod_t *nod
- ,int *dup
 ){
+  const nod_t *c;
+  unsigned long h;
   unsigned int i;
-  void *v;
+  unsigned int j;
 
-  for (i = 0; i < out->n; ++i)
-    if ((out->b + i)->n == nod && !outCmp((out->b + i)->i, infs)) {
-      *dup = 1;
-      return ((out->b + i)->l);
-    }
-  *dup = 0;
-  i = out->l++;
-  if ((v = realloc(out->b, (out->n + 1) * sizeof (*out->b)))) {
-    out->b = v;
-    (out->b + out->n)->i = infs;
-    (out->b + out->n)->n = nod;
-    (out->b + out->n)->l = i;
-    ++out->n;
+  if (!nod || can->e)
+    return (nod);
+  for (i = outCanVHsh(nod, can->ci) & (can->vm - 1); can->vm && (can->v + i)->n; i = (i + 1) & (can->vm - 1))
+    if ((can->v + i)->n == nod && (can->v + i)->ci == can->ci)
+      return ((can->v + i)->c);
+  /* the output is only of the nodes, after cchSav the memo is not used again */
+  ((nod_t *)nod)->nodV = outCanNod(can, nod->nodV);
+  ((nod_t *)nod)->nodO = outCanNod(can, nod->nodO);
+  if (((can->vn + 1) * 2 > can->vm && outCanVGrw(can))
+   || ((can->sn + 1) * 2 > can->sm && outCanSGrw(can))) {
+    can->e = 1;
+    return (nod);
   }
-  return (i);
+  h = outCanHsh(nod, can->ci);
+  for (j = h & (can->sm - 1); (can->s + j)->n; j = (j + 1) & (can->sm - 1))
+    if ((can->s + j)->h == h && (can->s + j)->ci == can->ci && !outCanCmp((can->s + j)->n, nod))
+      break;
+  if (!(c = (can->s + j)->n)) {
+    c = nod;
+    (can->s + j)->n = nod;
+    (can->s + j)->h = h;
+    (can->s + j)->ci = can->ci;
+    ++can->sn;
+  }
+  for (i = outCanVHsh(nod, can->ci) & (can->vm - 1); (can->v + i)->n; i = (i + 1) & (can->vm - 1));
+  (can->v + i)->n = nod;
+  (can->v + i)->c = c;
+  (can->v + i)->ci = can->ci;
+  ++can->vn;
+  return (c);
+}
+
+/* merge the nodes of the same output under the roots, return the number merged */
+static unsigned int
+outCan(
+  const nod_t **nods
+ ,unsigned int n
+){
+  outCan_t can;
+
+  memset(&can, 0, sizeof (can));
+  for (can.ci = 0; can.ci < n; ++can.ci)
+    *(nods + can.ci) = outCanNod(&can, *(nods + can.ci));
+  free(can.v);
+  free(can.s);
+  return (can.vn - can.sn);
 }
 
 /* output branch content */
@@ -2104,17 +5660,12 @@ outBrnCon(
   unsigned int i;
 
   if (infs)
-    for (i = 0; i < infs->n; ++i) {
-      printf("R,");
-      csvPrt((*(infs->v + i))->val->nam->sym->v, (*(infs->v + i))->val->nam->sym->n);
-      putchar(',');
-      csvPrt((*(infs->v + i))->val->sym->v, (*(infs->v + i))->val->sym->n);
-      putchar('\n');
-    }
+    for (i = 0; i < infs->n; ++i)
+      outLin(out, 'R', (*(infs->v + i))->val, 0);
   if (nod)
     outNod(out, nod);
   else
-    puts("J,0");
+    outNxt(out);
 }
 
 /* output branch with deduplication */
@@ -2129,9 +5680,9 @@ outBrn(
 
   l = outBrnLbl(out, infs, nod, &dup);
   if (dup) {
-    printf("J,%u\n", l);
+    outLin(out, 'J', 0, l);
   } else {
-    printf("L,%u\n", l);
+    outLin(out, 'L', 0, l);
     outBrnCon(out, infs, nod);
   }
 }
@@ -2149,34 +5700,416 @@ outNod(
   if (!nod)
     return;
   if (nod->lbl) {
-    printf("J,%u\n", nod->lbl);
+    outLin(out, 'J', 0, nod->lbl);
     return;
   }
   ((nod_t *)nod)->lbl = out->l++;
-  printf("L,%u\n", nod->lbl);
+  outLin(out, 'L', 0, nod->lbl);
   if (!nod->val) {
-    for (i = 0; nod->infsV && i < nod->infsV->n; ++i) {
-      printf("R,");
-      csvPrt((*(nod->infsV->v + i))->val->nam->sym->v, (*(nod->infsV->v + i))->val->nam->sym->n);
-      putchar(',');
-      csvPrt((*(nod->infsV->v + i))->val->sym->v, (*(nod->infsV->v + i))->val->sym->n);
-      putchar('\n');
-    }
+    for (i = 0; nod->infsV && i < nod->infsV->n; ++i)
+      outLin(out, 'R', (*(nod->infsV->v + i))->val, 0);
+    /* only a root, the last one falls through to the exit */
+    if (out->ci + 1 < out->cn)
+      outNxt(out);
     return;
   }
+  /* without room for the switch its tests are output as they are */
+  if (nodSwt(out->blds, nod) && !outSwt(out, nod))
+    return;
   l = outBrnLbl(out, nod->infsV, nod->nodV, &dup);
-  printf("T,");
-  csvPrt(nod->val->nam->sym->v, nod->val->nam->sym->n);
-  putchar(',');
-  csvPrt(nod->val->sym->v, nod->val->sym->n);
-  printf(",%u\n", l);
+  outLin(out, 'T', nod->val, l);
   outBrn(out, nod->infsO, nod->nodO);
   if (!dup) {
-    printf("L,%u\n", l);
+    outLin(out, 'L', 0, l);
     outBrnCon(out, nod->infsV, nod->nodV);
   }
 }
 
+/*
+ * Output the switch of nod and its O branches testing the same nam, a C for
+ * each like a T, the rest falls through. A node of the switch reached from
+ * elsewhere is output again as a switch of its own, from its val.
+ */
+static int
+outSwt(
+  out_t *out
+ ,const nod_t *nod
+){
+  const nod_t *n;
+  unsigned int *l;
+  unsigned int i;
+  unsigned int k;
+  int dup;
+
+  for (k = 1, n = nod; nodSwt(out->blds, n); n = n->nodO)
+    ++k;
+  if (!(l = malloc(k * sizeof (*l))))
+    return (1);
+  outLin(out, 'S', nod->val, 0);
+  /* a label with the high bit is a duplicate, its branch is output elsewhere */
+  for (k = 0, n = nod;; n = n->nodO) {
+    *(l + k) = outBrnLbl(out, n->infsV, n->nodV, &dup);
+    outLin(out, 'C', n->val, *(l + k));
+    if (dup)
+      *(l + k) |= ~(~0U >> 1);
+    ++k;
+    if (!nodSwt(out->blds, n))
+      break;
+  }
+  outBrn(out, n->infsO, n->nodO);
+  for (i = 0, n = nod; i < k; ++i, n = n->nodO)
+    if (!(*(l + i) & ~(~0U >> 1))) {
+      outLin(out, 'L', 0, *(l + i));
+      outBrnCon(out, n->infsV, n->nodV);
+    }
+  free(l);
+  return (0);
+}
+
+/* output sym as a C identifier, like C.awk: not alphanumeric is _, a leading digit gets a _ */
+static void
+outCId(
+  FILE *fp
+ ,const sym_t *sym
+){
+  unsigned int i;
+
+  if (sym->n && isdigit(*sym->v))
+    putc('_', fp);
+  for (i = 0; i < sym->n; ++i)
+    putc(isalnum(*(sym->v + i)) ? *(sym->v + i) : '_', fp);
+}
+
+/* output the enum constant of val, nm_nam_val */
+static void
+outCVal(
+  FILE *fp
+ ,const char *nm
+ ,const val_t *val
+){
+  fputs(nm, fp);
+  putc('_', fp);
+  outCId(fp, val->nam->sym);
+  putc('_', fp);
+  outCId(fp, val->sym);
+}
+
+/* output an enum per nam of v, its vals are in valCmp order, the one C.awk sorts them in */
+static void
+outCEnm(
+  FILE *fp
+ ,const char *nm
+ ,const val_t **v
+ ,unsigned int n
+){
+  unsigned int i;
+
+  for (i = 0; i < n; ++i) {
+    if (!i || (*(v + i))->nam != (*(v + i - 1))->nam) {
+      if (i)
+        fputs("};\n\n", fp);
+      fprintf(fp, "enum %s_", nm);
+      outCId(fp, (*(v + i))->nam->sym);
+      fputs("_e {\n ", fp);
+    } else
+      putc(',', fp);
+    outCVal(fp, nm, *(v + i));
+    putc('\n', fp);
+  }
+  if (n)
+    fputs("};\n\n", fp);
+}
+
+/* output the function head, a parameter per nam of the inputs iv and a pointer per nam of the outputs ov */
+static void
+outCSig(
+  FILE *fp
+ ,const char *nm
+ ,const val_t **iv
+ ,unsigned int in
+ ,const val_t **ov
+ ,unsigned int on
+){
+  unsigned int i;
+
+  fprintf(fp, "void\n%sEvaluate(\n", nm);
+  for (i = 0; i < in; ++i) {
+    if (i && (*(iv + i))->nam == (*(iv + i - 1))->nam)
+      continue;
+    fprintf(fp, "%senum %s_", i ? " ," : "  ", nm);
+    outCId(fp, (*(iv + i))->nam->sym);
+    fputs("_e ", fp);
+    outCId(fp, (*(iv + i))->nam->sym);
+    putc('\n', fp);
+  }
+  for (i = 0; i < on; ++i) {
+    if (i && (*(ov + i))->nam == (*(ov + i - 1))->nam)
+      continue;
+    fprintf(fp, " ,enum %s_", nm);
+    outCId(fp, (*(ov + i))->nam->sym);
+    fputs("_e *", fp);
+    outCId(fp, (*(ov + i))->nam->sym);
+    putc('\n', fp);
+  }
+}
+
+/*
+ * Output pfx.h and pfx.c as C.awk does from the pseudocode, from the lines
+ * -o c kept in out->o, without the round trip through CSV. The names are
+ * of the last part of pfx. Labels that are not jumped to are left out.
+ */
+static int
+outC(
+  const out_t *out
+ ,const char *prg
+ ,const char *pfx
+ ,const vals_t *vals
+ ,const infs_t *infs
+ ,unsigned int d
+){
+  FILE *fh;
+  FILE *fc;
+  const val_t **v;
+  const char *nm;
+  const char *a;
+  char *f;
+  unsigned char *t;
+  unsigned int n;
+  unsigned int i;
+  unsigned int sw;
+  int r;
+
+  r = 1;
+  fh = fc = 0;
+  v = 0;
+  t = 0;
+  nm = (a = strrchr(pfx, '/')) ? a + 1 : pfx;
+  if (!(f = malloc(strlen(pfx) + sizeof (".h")))
+   || !(v = malloc((infs->n ? infs->n : 1) * sizeof (*v)))
+   || !(t = calloc(out->l, sizeof (*t)))) {
+    fprintf(stderr, "%s: alloc fail\n", prg);
+    goto exit;
+  }
+  /* the outputs as the O lines */
+  for (n = i = 0; i < infs->n; ++i)
+    if (!n || (*(infs->v + i))->val != *(v + n - 1))
+      *(v + n++) = (*(infs->v + i))->val;
+  for (i = 0; i < out->on; ++i)
+    if ((out->o + i)->o == 'T'
+     || (out->o + i)->o == 'C'
+     || (out->o + i)->o == 'J')
+      *(t + (out->o + i)->l) = 1;
+
+  sprintf(f, "%s.h", pfx);
+  if (!(fh = fopen(f, "w"))) {
+    fprintf(stderr, "%s: Can't open %s\n", prg, f);
+    goto exit;
+  }
+  fputs("#ifndef ", fh);
+  for (a = nm; *a; ++a)
+    putc(toupper((unsigned char)*a), fh);
+  fputs("_H\n#define ", fh);
+  for (a = nm; *a; ++a)
+    putc(toupper((unsigned char)*a), fh);
+  fputs("_H\n\n", fh);
+  outCEnm(fh, nm, vals->v, vals->n);
+  outCEnm(fh, nm, v, n);
+  outCSig(fh, nm, vals->v, vals->n, v, n);
+  fputs(");\n\n#endif\n", fh);
+  if (fclose(fh)) {
+    fh = 0;
+    fprintf(stderr, "%s: write fail on %s\n", prg, f);
+    goto exit;
+  }
+  fh = 0;
+
+  sprintf(f, "%s.c", pfx);
+  if (!(fc = fopen(f, "w"))) {
+    fprintf(stderr, "%s: Can't open %s\n", prg, f);
+    goto exit;
+  }
+  setvbuf(fc, 0, _IOFBF, OUT_BUF);
+  fprintf(fc, "#include \"%s.h\"\n\n", nm);
+  outCSig(fc, nm, vals->v, vals->n, v, n);
+  fprintf(fc, "){\n  /* %u */\n", d);
+  /* the C lines of a switch end at the first other line */
+  for (sw = i = 0; i < out->on; ++i) {
+    if (sw && (out->o + i)->o != 'C') {
+      fputs("  default:\n    break;\n  }\n", fc);
+      sw = 0;
+    }
+    switch ((out->o + i)->o) {
+    case 'L':
+      if ((out->o + i)->l && *(t + (out->o + i)->l))
+        fprintf(fc, "L%u:\n", (out->o + i)->l);
+      break;
+    case 'T':
+      fputs("  if (", fc);
+      outCId(fc, (out->o + i)->v->nam->sym);
+      fputs(" == ", fc);
+      outCVal(fc, nm, (out->o + i)->v);
+      fprintf(fc, ")\n    goto L%u;\n", (out->o + i)->l);
+      break;
+    case 'S':
+      fputs("  switch (", fc);
+      outCId(fc, (out->o + i)->v->nam->sym);
+      fputs(") {\n", fc);
+      sw = 1;
+      break;
+    case 'C':
+      fputs("  case ", fc);
+      outCVal(fc, nm, (out->o + i)->v);
+      fprintf(fc, ":\n    goto L%u;\n", (out->o + i)->l);
+      break;
+    case 'J':
+      fprintf(fc, "  goto L%u;\n", (out->o + i)->l);
+      break;
+    case 'R':
+      fputs("  *", fc);
+      outCId(fc, (out->o + i)->v->nam->sym);
+      fputs(" = ", fc);
+      outCVal(fc, nm, (out->o + i)->v);
+      fputs(";\n", fc);
+      break;
+    }
+  }
+  fputs("L0:\n  return;\n}\n", fc);
+  i = fclose(fc);
+  fc = 0;
+  if (i) {
+    fprintf(stderr, "%s: write fail on %s\n", prg, f);
+    goto exit;
+  }
+  r = 0;
+exit:
+  if (fh)
+    fclose(fh);
+  if (fc)
+    fclose(fc);
+  free(t);
+  free(v);
+  free(f);
+  return (r);
+}
+
+/********************************************************************************/
+
+/* phases of main, the end of each in t */
+#define STS_PARSE 1
+#define STS_IND 2
+#define STS_BUILD 3
+#define STS_CHECK 4
+#define STS_OUTPUT 5
+
+static double
+stsNow(
+  void
+){
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (t.tv_sec + t.tv_nsec / 1e9);
+}
+
+/* print the array to the last non zero */
+static void
+stsArr(
+  const char *k
+ ,const unsigned long *v
+ ,unsigned int n
+){
+  unsigned int i;
+
+  while (n && !*(v + n - 1))
+    --n;
+  fprintf(stderr, "\"%s\":[", k);
+  for (i = 0; i < n; ++i)
+    fprintf(stderr, "%s%lu", i ? "," : "", *(v + i));
+  fputc(']', stderr);
+}
+
+/* --stats, one JSON object on stderr, phases not reached are left out */
+static void
+stsPrt(
+  const blds_t *blds
+ ,const double *t
+){
+  static const char *const p[] = {"", "parse", "ind", "build", "check", "output"};
+  struct rusage ru;
+  unsigned int i;
+  int c;
+
+  fputs("{\"phases\":{", stderr);
+  for (c = 0, i = STS_PARSE; i <= STS_OUTPUT && *(t + i); ++i, c = 1)
+    fprintf(stderr, "%s\"%s\":%.6f", c ? "," : "", p[i], *(t + i) - *(t + i - 1));
+  fputc('}', stderr);
+  if (blds) {
+    fprintf(stderr, ",\"memo\":{\"hits\":%lu,\"misses\":%lu,\"lb_cuts\":%lu,\"cache_hits\":%lu"
+     ",\"peak_entries\":%u,\"evicted\":%lu,\"arena_bytes\":%lu,\"limit_bytes\":%lu,\"over_limit_bytes\":%lu}"
+    ,blds->sts.hit
+    ,blds->sts.mis
+    ,blds->sts.cut
+    ,blds->sts.cch
+    ,blds->sts.pk
+    ,blds->sts.evc
+    ,bldsSz(blds)
+    ,blds->lim
+    ,blds->sts.ovr
+    );
+    fputs(",\"by_level\":{", stderr);
+    stsArr("expanded", blds->sts.exp, blds->vn + 1);
+    fputc(',', stderr);
+    stsArr("candidates", blds->sts.cnd, blds->vn + 1);
+    fputc(',', stderr);
+    stsArr("pruned", blds->sts.prn, blds->vn + 1);
+    fputc('}', stderr);
+  }
+  if (!getrusage(RUSAGE_SELF, &ru))
+    fprintf(stderr, ",\"peak_rss_kb\":%ld", ru.ru_maxrss);
+  fputs("}\n", stderr);
+}
+
+/********************************************************************************/
+
+/* --watch stamps of the files, zero for one that can't be stat */
+static void
+filStm(
+  char *fil[]
+ ,unsigned int n
+ ,struct stat *st
+){
+  unsigned int i;
+
+  for (i = 0; i < n; ++i)
+    if (stat(*(fil + i), st + i))
+      memset(st + i, 0, sizeof (*st));
+}
+
+/* wait, polling each second, for a file to differ from its stamp */
+/* one that can't be stat is being replaced, it is waited for */
+/* st_mtime is of seconds, the ctime, size and inode catch most edits within one */
+static void
+filWat(
+  char *fil[]
+ ,unsigned int n
+ ,const struct stat *st
+){
+  struct stat s;
+  unsigned int i;
+
+  for (;;) {
+    sleep(1);
+    for (i = 0; i < n; ++i)
+      if (!stat(*(fil + i), &s)
+       && (s.st_mtime != (st + i)->st_mtime
+        || s.st_ctime != (st + i)->st_ctime
+        || s.st_size != (st + i)->st_size
+        || s.st_ino != (st + i)->st_ino
+        || s.st_dev != (st + i)->st_dev))
+        return;
+  }
+}
+
 /********************************************************************************/
 
 int
@@ -2187,56 +6120,196 @@ main(
   struct csv *csv;
   vals_t *vals;
   blds_t *blds;
-  const nod_t *nod;
+  cch_t *cch;
+  struct {
+    vals_t *v;
+    infs_t *i;
+  } *cmp;
+  const nod_t **nods;
+  unsigned int *c;
+  unsigned int cn;
+  const char *cd;
+  const char *pf;
+  const char *wf;
+  const char *oc;
+  const char *po;
+  char *pt;
+  char *cf;
+  unsigned int *img;
+  struct stat *fs;
   unsigned int i;
   unsigned int b;
   unsigned int q;
+  unsigned int it;
+  unsigned int sw;
+  unsigned int t;
+  unsigned int tl;
+  unsigned int st;
+  unsigned int w;
+  unsigned int wt;
+  unsigned long ml;
+  unsigned int fi;
+  unsigned int ok;
+  double ts[STS_OUTPUT + 1];
+
+  q = it = sw = tl = st = w = wt = 0;
+  ml = 0;
+  t = 1;
+  cd = pf = wf = oc = po = 0;
+  for (i = 1; i < (unsigned int)argc; ++i) {
+    char *e;
+
+    if (!strcmp(argv[i], "-q"))
+      q = 1;
+    else if (!strcmp(argv[i], "-i"))
+      it = 1;
+    else if (!strcmp(argv[i], "-s"))
+      sw = 1;
+    else if (!strcmp(argv[i], "--stats"))
+      st = 1;
+    else if (!strcmp(argv[i], "--watch"))
+      wt = 1;
+    else if (!strcmp(argv[i], "--memo-limit") && i + 1 < (unsigned int)argc) {
+      ml = strtoul(argv[++i], &e, 10);
+      if (*e == 'k' || *e == 'K')
+        ml <<= 10, ++e;
+      else if (*e == 'm' || *e == 'M')
+        ml <<= 20, ++e;
+      else if (*e == 'g' || *e == 'G')
+        ml <<= 30, ++e;
+      if (*e || !ml)
+        break;
+    }
+    else if (!strcmp(argv[i], "-j") && i + 1 < (unsigned int)argc) {
+      t = strtoul(argv[++i], &e, 10);
+      if (*e || !t)
+        break;
+    } else if (!strcmp(argv[i], "-t") && i + 1 < (unsigned int)argc) {
+      tl = strtoul(argv[++i], &e, 10);
+      if (*e || !tl)
+        break;
+    } else if (!strcmp(argv[i], "-c") && i + 1 < (unsigned int)argc)
+      cd = argv[++i];
+    else if (!strcmp(argv[i], "-e") && i + 1 < (unsigned int)argc)
+      pf = argv[++i];
+    else if (!strcmp(argv[i], "-w") && i + 1 < (unsigned int)argc)
+      wf = argv[++i];
+    else if (!strcmp(argv[i], "-o") && i + 1 < (unsigned int)argc) {
+      if (!strcmp(argv[i + 1], "psu"))
+        oc = po = 0;
+      else if (!strncmp(argv[i + 1], "psu:", 4) && *(argv[i + 1] + 4)) {
+        po = argv[i + 1] + 4;
+        oc = 0;
+      } else if (!strncmp(argv[i + 1], "c:", 2) && *(argv[i + 1] + 2))
+        oc = argv[i + 1] + 2, po = 0;
+      else
+        break;
+      ++i;
+    } else
+      break;
+  }
+  if (i >= (unsigned int)argc || *argv[i] == '-') {
+    fprintf(stderr, "Usage: %s [-q] [-i] [-s] [-j threads] [-t seconds] [-c cachedir] [-e profile] [-w costs] [-o psu|psu:file|c:prefix] [--stats] [--watch] [--memo-limit bytes] file ...\n", argv[0]);
+    return (1);
+  }
+#if !DTC_PTHREAD
+  if (t > 1) {
+    fprintf(stderr, "%s: -j needs a build with DTC_PTHREAD\n", argv[0]);
+    return (1);
+  }
+#endif
+  /* each compile replaces the output, so it is not stdout */
+  if (wt && !oc && !po) {
+    fprintf(stderr, "%s: --watch needs -o psu:file or -o c:prefix\n", argv[0]);
+    return (1);
+  }
+  /* the cache is of the smallest d */
+  if (cd && (pf || wf || sw)) {
+    fprintf(stderr, "%s: -c is ignored with %s\n", argv[0], pf ? "-e" : wf ? "-w" : "-s");
+    cd = 0;
+  }
+  /* fully buffered in large chunks, also to a terminal or pipe */
+  setvbuf(stdout, 0, _IOFBF, OUT_BUF);
+  cf = 0;
+  pt = 0;
+  img = 0;
+  fs = 0;
+  /* one cache file per set of files (and -q) */
+  if (cd) {
+    const char *a;
+    unsigned int h;
+    unsigned int j;
 
-  if ((argc > 1 && !strcmp(argv[1], "-q") && argc < 3) || argc < 2) {
-    fprintf(stderr, "Usage: %s [-] file ...\n", argv[0]);
+    h = 2166136261U;
+    for (j = i; j < (unsigned int)argc; ++j)
+      for (a = argv[j];; ++a) {
+        h = (h ^ (unsigned char)*a) * 16777619U;
+        if (!*a)
+          break;
+      }
+    if (!(cf = malloc(strlen(cd) + sizeof ("/12345678.dtcc")))) {
+      fprintf(stderr, "%s: alloc fail\n", argv[0]);
+      return (1);
+    }
+    sprintf(cf, "%s/%08x.dtcc", cd, h ^ q);
+  }
+  /* -o psu:file replaces file when the output is complete */
+  if (po) {
+    if (!(pt = malloc(strlen(po) + sizeof (".tmp")))) {
+      fprintf(stderr, "%s: alloc fail\n", argv[0]);
+      free(cf);
+      return (1);
+    }
+    sprintf(pt, "%s.tmp", po);
+  }
+  /* --watch keeps the solved subproblems between compiles in an image of the cache */
+  if (wt && !(fs = calloc(argc - i, sizeof (*fs)))) {
+    fprintf(stderr, "%s: alloc fail\n", argv[0]);
+    free(pt);
+    free(cf);
     return (1);
   }
+  fi = i;
+
+run:
+  memset(ts, 0, sizeof (ts));
+  *ts = stsNow();
+  i = fi;
+  if (wt)
+    filStm(argv + fi, argc - fi, fs);
+  nodStp = 0;
+  ok = 0;
   vals = 0;
   blds = 0;
-  if (!(csv = calloc(1, sizeof (*csv)))
-   || !(csv->syms = symsNew())
-   || !(csv->nams = namsNew())
-   || !(csv->infs = infsNew())) {
-    fprintf(stderr, "%s: alloc fail\n", argv[0]);
+  cch = 0;
+  cmp = 0;
+  nods = 0;
+  c = 0;
+  cn = 0;
+  csv = 0;
+  if (pt && !freopen(pt, "w", stdout)) {
+    fprintf(stderr, "%s: Can't open %s\n", argv[0], pt);
     goto exit;
   }
-  if (!strcmp(argv[1], "-q"))
-    q = 1, i = 2;
-  else
-    q = 0, i = 1;
-  for (; i < (unsigned int)argc; ++i) {
-    unsigned char *bf;
-    int fd;
-    int sz;
-
-    if ((fd = open(argv[i], O_RDONLY)) < 0) {
-      fprintf(stderr, "%s: Can't open %s\n", argv[0], argv[i]);
-      goto exit;
-    }
-    bf = 0;
-    if ((sz = lseek(fd, 0, SEEK_END)) < 0
-     || lseek(fd, 0, SEEK_SET) < 0
-     || !(bf = malloc(sz))
-     || read(fd, bf, sz) != sz) {
-      fprintf(stderr, "%s: data fail on %s\n", argv[0], argv[i]);
-      free(bf);
-      close(fd);
+  if (pt)
+    setvbuf(stdout, 0, _IOFBF, OUT_BUF);
+#if DTC_PTHREAD
+  /* with -j the files are parsed at the same time */
+  if (t > 1 && i + 1 < (unsigned int)argc) {
+    if (!(csv = csvPar(argv[0], argv + i, argc - i, t)))
       goto exit;
-    }
-    close(fd);
-    csv->fil = (unsigned char *)argv[i];
-    if (csvParse(csvCb, bf, sz, csv) != sz) {
-      fprintf(stderr, "%s: CSV parse fail on %s\n", argv[0], argv[i]);
-      free(bf);
+  } else
+#endif
+  {
+    if (!(csv = csvNew(stderr))) {
+      fprintf(stderr, "%s: alloc fail\n", argv[0]);
       goto exit;
     }
-    free(bf);
+    for (; i < (unsigned int)argc; ++i)
+      if (csvFil(csv, argv[0], argv[i]))
+        goto exit;
   }
+  *(ts + STS_PARSE) = stsNow();
 #if DTC_DEBUG
   infsPrt(csv->infs);
   putchar('\n');
@@ -2269,6 +6342,14 @@ main(
   }
   if (b)
     goto exit;
+  if (csvIdx(csv)) {
+    fprintf(stderr, "%s: alloc fail\n", argv[0]);
+    goto exit;
+  }
+  if (pf && prfLod(csv, argv[0], pf))
+    goto exit;
+  if (wf && cstLod(csv, argv[0], wf, &w))
+    goto exit;
   if (!(vals = namsInd(csv->nams, csv->infs)) || !vals->n) {
     fprintf(stderr, "%s: There are no independent values\n", argv[0]);
     goto exit;
@@ -2292,58 +6373,215 @@ main(
   if (b)
     goto exit;
   fprintf(stderr, "%s: Independent values: %u\n", argv[0], vals->n);
-  for (i = 0; i < vals->n; ++i) {
-    printf("I,");
-    csvPrt((*(vals->v + i))->nam->sym->v, (*(vals->v + i))->nam->sym->n);
-    putchar(',');
-    csvPrt((*(vals->v + i))->sym->v, (*(vals->v + i))->sym->n);
-    putchar('\n');
+  if ((i = valsEq(vals)) == ~0U) {
+    fprintf(stderr, "%s: alloc fail\n", argv[0]);
+    goto exit;
+  }
+  if (i)
+    fprintf(stderr, "%s: Interchangeable values: %u\n", argv[0], i);
+  /* vals and infs of each independent subproblem, in their order */
+  if (!(c = malloc(csv->nams->n * sizeof (*c)))
+   || (cn = namsSpl(csv->nams, csv->infs, c)) == ~0U
+   || !(cmp = calloc(cn ? cn : 1, sizeof (*cmp)))
+   || !(nods = calloc(cn ? cn : 1, sizeof (*nods)))) {
+    cn = 0;
+    fprintf(stderr, "%s: alloc fail\n", argv[0]);
+    goto exit;
   }
+  for (i = 0; i < cn; ++i)
+    if (!((cmp + i)->v = valsNew())
+     || !((cmp + i)->v->v = malloc(vals->n * sizeof (*(cmp + i)->v->v)))
+     || !((cmp + i)->i = infsNew())
+     || !((cmp + i)->i->v = malloc(csv->infs->n * sizeof (*(cmp + i)->i->v)))) {
+      fprintf(stderr, "%s: alloc fail\n", argv[0]);
+      goto exit;
+    }
+  for (i = 0; i < vals->n; ++i)
+    if ((b = *(c + (*(vals->v + i))->nam->rnk - 1)) != ~0U)
+      *((cmp + b)->v->v + (cmp + b)->v->n++) = *(vals->v + i);
   for (i = 0; i < csv->infs->n; ++i) {
+    b = *(c + (*(csv->infs->v + i))->val->nam->rnk - 1);
+    *((cmp + b)->i->v + (cmp + b)->i->n++) = *(csv->infs->v + i);
+  }
+  if (cn > 1)
+    fprintf(stderr, "%s: Independent subproblems: %u\n", argv[0], cn);
+  /* with -o c nothing goes to stdout */
+  for (i = 0; !oc && i < vals->n; ++i) {
+    outSym("I", *(vals->v + i));
+    putchar('\n');
+  }
+  for (i = 0; !oc && i < csv->infs->n; ++i) {
     if (i && (*(csv->infs->v + i))->val == (*(csv->infs->v + i - 1))->val)
       continue;
-    printf("O,");
-    csvPrt((*(csv->infs->v + i))->val->nam->sym->v, (*(csv->infs->v + i))->val->nam->sym->n);
-    putchar(',');
-    csvPrt((*(csv->infs->v + i))->val->sym->v, (*(csv->infs->v + i))->val->sym->n);
+    outSym("O", (*(csv->infs->v + i))->val);
     putchar('\n');
   }
   fflush(stdout);
-  if (!(blds = bldsNew())
-   || !(nod = nodBld(blds, vals, csv->infs, vals->n, q))) {
-    fprintf(stderr, "%s: build failed (out of memory)\n", argv[0]);
+  if ((cf || (wt && !cd && !pf && !wf && !sw)) && !(cch = cchNew(argv[0], cf, img, csv, q))) {
+    fprintf(stderr, "%s: alloc fail\n", argv[0]);
+    goto exit;
+  }
+
+  /* the first SIGINT, or the time limit, ends the search with the best so far */
+  {
+    struct sigaction sa;
+
+    memset(&sa, 0, sizeof (sa));
+    sa.sa_handler = nodStpSig;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGALRM, &sa, 0);
+    sa.sa_flags = SA_RESETHAND;
+    sigaction(SIGINT, &sa, 0);
+    if (it)
+      nodStpTo = 2;
+    if (tl)
+      alarm(tl);
+  }
+
+  *(ts + STS_IND) = stsNow();
+
+  /* the independent subproblems are built one after the other */
+  if (!(blds = bldsNew(csv->valn))) {
+    fprintf(stderr, "%s: alloc fail\n", argv[0]);
     goto exit;
   }
+  blds->cch = cch;
+  blds->e = pf != 0;
+  blds->cst = w;
+  blds->s = sw;
+  bldsLim(blds, ml);
+  for (i = 0; i < cn; ++i)
+    if (!(*(nods + i) = nodBldTop(blds, (cmp + i)->v, (cmp + i)->i, it, q, t))
+     || (ml && bldsRt(blds, nods + i))) {
+      fprintf(stderr, "%s: build failed (out of memory)\n", argv[0]);
+      goto exit;
+    }
+  alarm(0);
+  if (blds->sts.ovr)
+    fprintf(stderr, "%s: memo over --memo-limit by up to %lu bytes, the entries and nodes in use need more\n", argv[0], blds->sts.ovr);
+  if (tl || nodStp) {
+    unsigned int d;
+
+    for (d = b = i = 0; i < cn; ++i) {
+      b += nodLb(blds, (cmp + i)->v, (cmp + i)->i);
+      if (d != ~0U)
+        d = (*(nods + i))->val ? d + (*(nods + i))->d + 1 : ~0U;
+    }
+    fprintf(stderr, "%s: Depth: %u, lower bound %u, %s, %s\n", argv[0]
+    ,d != ~0U ? d : 0
+    ,b
+    ,d != ~0U && d <= b ? "optimal" : "optimality not proven"
+    ,nodStp ? "search stopped" : "search complete"
+    );
+  }
+  /* a stopped search memoized quick results, keep them out of the cache */
+  if (cch && !nodStp && cchSav(cf, &img, csv, blds, cch, q))
+    fprintf(stderr, "%s: can't write cache %s\n", argv[0], cf ? cf : "image");
+  *(ts + STS_BUILD) = stsNow();
 #if DTC_DEBUG
   puts("\nblds\n");
   bldsPrt(blds);
-  puts("\nnod\n");
-  nodPrt(nod);
-  puts("\nnst\n");
-  nodNstPrt(nod, 0);
+  for (i = 0; i < cn; ++i) {
+    puts("\nnod\n");
+    nodPrt(*(nods + i));
+    puts("\nnst\n");
+    nodNstPrt(*(nods + i), 0);
+  }
   puts("\nend\n");
 #endif
 
   /* check for unresolvable inferences (same name with different values) */
-  if (nodChk(nod, argv[0]))
+  for (b = i = 0; i < cn; ++i)
+    b |= nodChk(*(nods + i), argv[0]);
+  *(ts + STS_CHECK) = stsNow();
+  if (b)
     goto exit;
 
   /* output pseudocode */
   {
     out_t out;
 
-    printf("D,%u\n", nod->d + 1);
+    if ((i = outCan(nods, cn)))
+      fprintf(stderr, "%s: Merged nodes: %u\n", argv[0], i);
+    for (b = i = 0; i < cn; ++i)
+      b += (*(nods + i))->d + 1;
+    if (!oc)
+      printf("D,%u\n", b);
+    if (pf && !oc) {
+      double e;
+
+      for (e = 0, i = 0; i < cn; ++i)
+        e += (*(nods + i))->e;
+      printf("E,%.6g\n", e);
+    }
     out.b = 0;
     out.n = 0;
+    out.a = 0;
+    out.h = 0;
+    out.m = 0;
     out.l = 1;
-    outNod(&out, nod);
-    puts("L,0");
+    out.c = nods;
+    out.cn = cn;
+    out.ci = 0;
+    out.blds = blds;
+    out.o = 0;
+    out.on = 0;
+    out.oa = 0;
+    out.oc = !!oc;
+    out.oe = 0;
+    outNod(&out, *nods);
+    outLin(&out, 'L', 0, 0);
+    free(out.h);
     free(out.b);
+    if (oc && out.oe)
+      fprintf(stderr, "%s: alloc fail\n", argv[0]);
+    else if (oc)
+      ok = !outC(&out, argv[0], oc, vals, csv->infs, b);
+    else
+      ok = 1;
+    free(out.o);
+    if (fflush(stdout) && pt) {
+      fprintf(stderr, "%s: write fail on %s\n", argv[0], pt);
+      ok = 0;
+    }
   }
+  *(ts + STS_OUTPUT) = stsNow();
 
 exit:
+  if (st)
+    stsPrt(blds, ts);
+  for (i = 0; cmp && i < cn; ++i) {
+    valsRefFre((cmp + i)->v);
+    infsRefFre((cmp + i)->i);
+  }
+  free(cmp);
+  free(nods);
+  free(c);
   bldsFre(blds);
+  cchFre(cch);
   valsRefFre(vals);
   csvFre(csv);
+  if (pt && ok && rename(pt, po)) {
+    fprintf(stderr, "%s: Can't rename %s\n", argv[0], pt);
+    ok = 0;
+  }
+  if (pt && !ok)
+    remove(pt);
+  if (wt) {
+    struct sigaction sa;
+
+    /* an interrupt while waiting ends dtc */
+    memset(&sa, 0, sizeof (sa));
+    sa.sa_handler = SIG_DFL;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, 0);
+    fprintf(stderr, "%s: %s, watching for changes\n", argv[0], ok ? "done" : "failed");
+    filWat(argv + fi, argc - fi, fs);
+    goto run;
+  }
+  free(fs);
+  free(img);
+  free(pt);
+  free(cf);
   return (0);
 }
@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+"""
+Generate synthetic decision tables (.dtc) for benchmarking.
+
+Usage: python3 gen.py names values sparsity chain seed [outputs] > table.dtc
+
+  names     number of independent (input) names
+  values    values per name
+  sparsity  chance (0..1) that a cell below the first test is "don't care"
+  chain     number of table layers, the first chain - 1 resolve intermediate
+            names that the next layer depends on (the bridge pattern)
+  seed      random seed, the same arguments always give the same tables
+  outputs   tables per layer (default 1)
+
+Every table is complete: its rows partition all combinations of the names
+it depends on. Tables with chain > 1 can still be reported unresolvable
+when a layer's result does not determine the next one's tests.
+"""
+
+import sys
+import random
+
+
+def table(rnd, result, depends, values, sparsity, results):
+    """One @result table over the depends names, a random complete partition."""
+    leaves = []
+
+    def walk(path, avail, depth):
+        if avail and (depth == 0 or rnd.random() > sparsity):
+            name = rnd.choice(avail)
+            rest = [n for n in avail if n != name]
+            for val in values[name]:
+                walk(path + [(name, val)], rest, depth + 1)
+        else:
+            leaves.append(path)
+
+    walk([], list(depends), 0)
+    # every result value is used at least once
+    out = results[:min(len(results), len(leaves))]
+    assign = out + [rnd.choice(out) for _ in range(len(leaves) - len(out))]
+    rnd.shuffle(assign)
+    used = sorted(set(n for p in leaves for n, _ in p))
+    lines = ['@' + result + ',' + ','.join(used)]
+    for path, res in zip(leaves, assign):
+        cells = dict(path)
+        lines.append(res + ',' + ','.join(cells.get(n, '') for n in used))
+    return lines, out
+
+
+def generate(names, nvalues, sparsity, chain, seed, outputs=1):
+    """The text of the generated .dtc file."""
+    rnd = random.Random(seed)
+    inputs = ['i%d' % k for k in range(names)]
+    values = {n: ['v%d' % j for j in range(nvalues)] for n in inputs}
+    lines = ['# gen.py %d %d %g %d %d %d' % (names, nvalues, sparsity, chain, seed, outputs), '']
+    depends = inputs
+    for c in range(chain):
+        layer = []
+        for o in range(outputs):
+            result = ('m%d_%d' % (c, o)) if c < chain - 1 else ('o%d' % o)
+            rows, out = table(rnd, result, depends, values, sparsity,
+                              ['r%d' % j for j in range(nvalues)])
+            lines += rows + ['']
+            values[result] = out
+            layer.append(result)
+        # the second layer also sees the inputs, later ones only the layer before
+        depends = layer + (depends if c == 0 else [])
+    return '\n'.join(lines) + '\n'
+
+
+def main():
+    if len(sys.argv) not in (6, 7):
+        print(__doc__.strip().split('\n\n')[1], file=sys.stderr)
+        sys.exit(1)
+    a = sys.argv[1:]
+    sys.stdout.write(generate(int(a[0]), int(a[1]), float(a[2]), int(a[3]), int(a[4]),
+                              int(a[5]) if len(a) > 5 else 1))
+
+
+if __name__ == '__main__':
+    main()
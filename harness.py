@@ -0,0 +1,396 @@
+#!/usr/bin/env python3
+"""
+Generate a C check and timing harness for a translated decision table.
+
+Usage: python3 harness.py [--batch] [--samples n] table.psu table.dtc ... > table_check.c
+
+The harness calls tableEvaluate() (from C.awk output of table.psu, in any of
+its modes) on every combination of the I, values, or on n random ones when
+there are more (default 1048576), and checks each against a reference that
+matches the rows of the .dtc files directly. It then reports nanoseconds per
+call and, on Linux when perf counters are allowed, branch misses per call.
+With --batch tableEvaluateN() (C.awk -v batch=1) is checked and timed as well.
+
+Build: cc -O2 -o table_check table_check.c table.c
+The exit status is 1 when an output differs from the reference.
+"""
+
+import csv
+import os
+import sys
+
+
+def to_c_ident(s):
+    """As C.awk's to_c_ident."""
+    r = ''.join(c if c.isascii() and c.isalnum() else '_' for c in s)
+    return '_' + r if r[:1].isdigit() else r
+
+
+def load_psu(path):
+    """The I and O names in order of appearance, each with its values."""
+    inputs, outputs = {}, {}
+    with open(path, newline='') as f:
+        for r in csv.reader(f):
+            if len(r) == 3 and r[0] in ('I', 'O'):
+                d = inputs if r[0] == 'I' else outputs
+                if r[2] not in d.setdefault(r[1], []):
+                    d[r[1]].append(r[2])
+    return inputs, outputs
+
+
+def load_dtc(paths):
+    """The rows of the tables, (result name, result value, [(name, value)])."""
+    rows = []
+    for path in paths:
+        head = None
+        with open(path, newline='') as f:
+            for r in csv.reader(f):
+                if not r or not any(r) or r[0].startswith('#'):
+                    continue
+                if r[0].startswith('@'):
+                    head = [r[0][1:]] + r[1:]
+                    continue
+                if head is None:
+                    sys.exit('%s: row before any @name row' % path)
+                rows.append((head[0], r[0], [(n, v) for n, v in zip(head[1:], r[1:]) if v]))
+    return rows
+
+
+def generate(name, inputs, outputs, rows, samples, batch):
+    names = list(inputs) + list(outputs)
+    # enum values are the ranks of the sorted values, as in C.awk
+    rank = {n: {v: i for i, v in enumerate(sorted(vs))}
+            for n, vs in list(inputs.items()) + list(outputs.items())}
+    index = {n: i for i, n in enumerate(names)}
+    ni, no = len(inputs), len(outputs)
+    space = 1
+    for vs in inputs.values():
+        space *= len(vs)
+    exhaustive = space <= samples
+    count = space if exhaustive else samples
+
+    refs, conds = [], []
+    for res, val, cs in rows:
+        if res not in index or val not in rank[res] \
+                or any(n not in index or v not in rank[n] for n, v in cs):
+            sys.exit('harness: a .dtc row is not in the .psu, is it of this table?')
+        refs.append('{%d, %d, %d, %d}' % (index[res], rank[res][val], len(conds), len(cs)))
+        conds += ['{%d, %d}' % (index[n], rank[n][v]) for n, v in cs]
+
+    o = []
+    o.append('/* Generated by harness.py from %s - do not edit */' % name)
+    o.append('')
+    o.append('#include <stdio.h>')
+    o.append('#include <stdlib.h>')
+    o.append('#include <string.h>')
+    o.append('#include <time.h>')
+    o.append('#ifdef __linux__')
+    o.append('#include <unistd.h>')
+    o.append('#include <sys/ioctl.h>')
+    o.append('#include <sys/syscall.h>')
+    o.append('#include <linux/perf_event.h>')
+    o.append('#endif')
+    o.append('#include "%s.h"' % name)
+    o.append('')
+    o.append('#define NI %d' % ni)
+    o.append('#define NN %d' % (ni + no))
+    o.append('#define COUNT %dUL' % count)
+    o.append('')
+    o.append('static const char *const names[NN] = {%s};' % ', '.join(
+        '"%s"' % n.replace('\\', '\\\\').replace('"', '\\"') for n in names))
+    o.append('static const unsigned int radix[NI] = {%s};' % ', '.join(
+        str(len(vs)) for vs in inputs.values()))
+    o.append('')
+    o.append('/* rows: result name, result value, first condition, conditions */')
+    o.append('static const unsigned int refs[][4] = {')
+    o.append('  ' + '\n ,'.join(refs or ['{0, 0, 0, 0}']))
+    o.append('};')
+    o.append('static const unsigned int conds[][2] = {')
+    o.append('  ' + '\n ,'.join(conds or ['{0, 0}']))
+    o.append('};')
+    o.append('')
+    o.append('''/* the values of the names resolved by matching the rows over and over, -1 unresolved */
+static void
+ref(
+  int *v
+){
+  unsigned int r;
+  unsigned int c;
+  int more;
+
+  for (more = 1; more;)
+    for (more = 0, r = 0; r < %d; ++r) {
+      if (v[refs[r][0]] >= 0)
+        continue;
+      for (c = 0; c < refs[r][3]; ++c)
+        if (v[conds[refs[r][2] + c][0]] != (int)conds[refs[r][2] + c][1])
+          break;
+      if (c == refs[r][3]) {
+        v[refs[r][0]] = (int)refs[r][1];
+        more = 1;
+      }
+    }
+}''' % len(refs))
+    o.append('')
+    o.append('''/* input combination k, every one or a random one */
+static void
+input(
+  unsigned long k
+ ,int *v
+){
+  static unsigned long s = 88172645463325252UL;
+  unsigned int i;
+
+  if (!%d) {
+    s ^= s << 13;
+    s ^= s >> 7;
+    s ^= s << 17;
+    k = s;
+  }
+  for (i = NI; i--; k /= radix[i])
+    v[i] = (int)(k %% radix[i]);
+}''' % (1 if exhaustive else 0))
+    o.append('')
+    o.append('''static double
+now(
+  void
+){
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (t.tv_sec + t.tv_nsec / 1e9);
+}
+
+/* branch misses from here on, -1 without perf counters */
+static int
+missOpen(
+  void
+){
+#ifdef __linux__
+  struct perf_event_attr a;
+  int fd;
+
+  memset(&a, 0, sizeof (a));
+  a.type = PERF_TYPE_HARDWARE;
+  a.size = sizeof (a);
+  a.config = PERF_COUNT_HW_BRANCH_MISSES;
+  a.exclude_kernel = 1;
+  a.exclude_hv = 1;
+  if ((fd = syscall(SYS_perf_event_open, &a, 0, -1, -1, 0)) >= 0)
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+  return (fd);
+#else
+  return (-1);
+#endif
+}
+
+static long long
+missRead(
+  int fd
+){
+  long long n;
+
+  if (fd < 0 || read(fd, &n, sizeof (n)) != sizeof (n))
+    n = -1;
+  if (fd >= 0)
+    close(fd);
+  return (n);
+}
+
+static void
+report(
+  const char *what
+ ,double t
+ ,long long m
+ ,unsigned long calls
+){
+  printf("%s: %.2f ns/call", what, t * 1e9 / calls);
+  if (m >= 0)
+    printf(", %.3f branch misses/call", (double)m / calls);
+  else
+    printf(", branch misses n/a");
+  printf(" (%lu calls)\\n", calls);
+}''')
+    o.append('')
+    args = ', '.join('(enum %s_%s_e)v[%d]' % (name, to_c_ident(n), i) for i, n in enumerate(inputs))
+    outs = ', '.join('&%s' % ('o' + str(j)) for j in range(no))
+    o.append('int')
+    o.append('main(')
+    o.append('  void')
+    o.append('){')
+    for j, n in enumerate(outputs):
+        o.append('  enum %s_%s_e o%d;' % (name, to_c_ident(n), j))
+    o.append('  int v[NN];')
+    o.append('  int (*in)[NI];')
+    o.append('  unsigned long sum;')
+    o.append('  unsigned long k;')
+    o.append('  unsigned long bad;')
+    o.append('  unsigned int r;')
+    o.append('  unsigned int j;')
+    o.append('  double t;')
+    o.append('  long long m;')
+    o.append('  int fd;')
+    o.append('')
+    o.append('  if (!(in = malloc(COUNT * sizeof (*in)))) {')
+    o.append('    fprintf(stderr, "alloc fail\\n");')
+    o.append('    return (2);')
+    o.append('  }')
+    o.append('  /* check, an output the reference leaves unresolved must be left as it was */')
+    o.append('  for (bad = k = 0; k < COUNT; ++k) {')
+    o.append('    input(k, v);')
+    o.append('    memcpy(in[k], v, sizeof (in[k]));')
+    o.append('    for (j = NI; j < NN; ++j)')
+    o.append('      v[j] = -1;')
+    o.append('    ref(v);')
+    for j in range(no):
+        o.append('    o%d = (enum %s_%s_e)%d;' % (j, name, to_c_ident(list(outputs)[j]), len(list(outputs.values())[j])))
+    o.append('    %sEvaluate(%s, %s);' % (name, args, outs))
+    o.append('    for (j = 0; j < %d; ++j) {' % no)
+    o.append('      int e;')
+    o.append('      int w;')
+    o.append('')
+    o.append('      switch (j) {')
+    for j, vs in enumerate(outputs.values()):
+        o.append('      case %d: e = (int)o%d; w = %d; break;' % (j, j, len(vs)))
+    o.append('      default: e = w = 0; break;')
+    o.append('      }')
+    o.append('      if (e == w)')
+    o.append('        e = -1;')
+    o.append('      if (e != v[NI + j] && bad++ < 10) {')
+    o.append('        printf("differs at");')
+    o.append('        for (r = 0; r < NI; ++r)')
+    o.append('          printf(" %s=%d", names[r], v[r]);')
+    o.append('        printf(": %s is %d, the rows give %d\\n", names[NI + j], e, v[NI + j]);')
+    o.append('      }')
+    o.append('    }')
+    o.append('  }')
+    o.append('  printf("%%lu %%s, %%lu differ\\n", COUNT, %s, bad);' % (
+        '"inputs (all)"' if exhaustive else '"random inputs of %d"' % space))
+    if batch:
+        o += batch_check(name, inputs, outputs)
+    o.append('')
+    o.append('  /* time, repeated to about 10^7 calls */')
+    o.append('  r = COUNT < 10000000UL ? 10000000UL / COUNT : 1;')
+    o.append('  sum = 0;')
+    o.append('  fd = missOpen();')
+    o.append('  t = now();')
+    o.append('  for (j = 0; j < r; ++j)')
+    o.append('    for (k = 0; k < COUNT; ++k) {')
+    o.append('      int *x = in[k];')
+    o.append('')
+    o.append('      %sEvaluate(%s, %s);' % (name, args.replace('v[', 'x['), outs))
+    for j in range(no):
+        o.append('      sum += (unsigned long)o%d;' % j)
+    o.append('    }')
+    o.append('  t = now() - t;')
+    o.append('  m = missRead(fd);')
+    o.append('  report("%sEvaluate", t, m, r * COUNT);' % name)
+    if batch:
+        o += batch_time(name, inputs, outputs)
+    o.append('  /* keeps the calls */')
+    o.append('  if (sum == 1)')
+    o.append('    putchar(\'\\n\');')
+    o.append('  free(in);')
+    o.append('  return (bad != 0);')
+    o.append('}')
+    return '\n'.join(o) + '\n'
+
+
+def batch_arrays(name, inputs, outputs):
+    o = []
+    o.append('  {')
+    for i, n in enumerate(inputs):
+        o.append('    enum %s_%s_e *i%d;' % (name, to_c_ident(n), i))
+    for j, n in enumerate(outputs):
+        o.append('    enum %s_%s_e *b%d;' % (name, to_c_ident(n), j))
+    o.append('')
+    for i in range(len(inputs)):
+        o.append('    i%d = malloc(COUNT * sizeof (*i%d));' % (i, i))
+    for j in range(len(outputs)):
+        o.append('    b%d = malloc(COUNT * sizeof (*b%d));' % (j, j))
+    o.append('    if (%s) {' % ' || '.join(['!i%d' % i for i in range(len(inputs))]
+                                          + ['!b%d' % j for j in range(len(outputs))]))
+    o.append('      fprintf(stderr, "alloc fail\\n");')
+    o.append('      return (2);')
+    o.append('    }')
+    o.append('    for (k = 0; k < COUNT; ++k) {')
+    for i, n in enumerate(inputs):
+        o.append('      i%d[k] = (enum %s_%s_e)in[k][%d];' % (i, name, to_c_ident(n), i))
+    for j, (n, vs) in enumerate(outputs.items()):
+        o.append('      b%d[k] = (enum %s_%s_e)%d;' % (j, name, to_c_ident(n), len(vs)))
+    o.append('    }')
+    return o
+
+
+def batch_call(name, inputs, outputs):
+    return '%sEvaluateN(COUNT, %s, %s);' % (
+        name, ', '.join('i%d' % i for i in range(len(inputs))),
+        ', '.join('b%d' % j for j in range(len(outputs))))
+
+
+def batch_free(inputs, outputs):
+    return ['    free(i%d);' % i for i in range(len(inputs))] \
+        + ['    free(b%d);' % j for j in range(len(outputs))] + ['  }']
+
+
+def batch_check(name, inputs, outputs):
+    """Check EvaluateN against Evaluate, element by element."""
+    args = ', '.join('(enum %s_%s_e)in[k][%d]' % (name, to_c_ident(n), i) for i, n in enumerate(inputs))
+    outs = ', '.join('&o%d' % j for j in range(len(outputs)))
+    o = ['', '  /* the batch is checked against the scalar function */']
+    o += batch_arrays(name, inputs, outputs)
+    o.append('    ' + batch_call(name, inputs, outputs))
+    o.append('    for (r = 0, k = 0; k < COUNT; ++k) {')
+    for j, (n, vs) in enumerate(outputs.items()):
+        o.append('      o%d = (enum %s_%s_e)%d;' % (j, name, to_c_ident(n), len(vs)))
+    o.append('      %sEvaluate(%s, %s);' % (name, args, outs))
+    o.append('      if (%s)' % ' || '.join('o%d != b%d[k]' % (j, j) for j in range(len(outputs))))
+    o.append('        ++r;')
+    o.append('    }')
+    o.append('    printf("%sEvaluateN: %%u differ from %sEvaluate\\n", r);' % (name, name))
+    o.append('    if (r)')
+    o.append('      bad += r;')
+    o += batch_free(inputs, outputs)
+    return o
+
+
+def batch_time(name, inputs, outputs):
+    o = ['', '  /* time the batch over the same inputs */']
+    o += batch_arrays(name, inputs, outputs)
+    o.append('    r = COUNT < 10000000UL ? 10000000UL / COUNT : 1;')
+    o.append('    fd = missOpen();')
+    o.append('    t = now();')
+    o.append('    for (j = 0; j < r; ++j)')
+    o.append('      ' + batch_call(name, inputs, outputs))
+    o.append('    t = now() - t;')
+    o.append('    m = missRead(fd);')
+    o.append('    report("%sEvaluateN", t, m, r * COUNT);' % name)
+    o.append('    for (k = 0; k < COUNT; ++k)')
+    o.append('      sum += (unsigned long)b0[k];' if outputs else '      ;')
+    o += batch_free(inputs, outputs)
+    return o
+
+
+def main():
+    args = sys.argv[1:]
+    batch = False
+    samples = 1 << 20
+    while args and args[0].startswith('--'):
+        if args[0] == '--batch':
+            batch = True
+            args = args[1:]
+        elif args[0] == '--samples' and len(args) > 1 and args[1].isdigit() and int(args[1]):
+            samples = int(args[1])
+            args = args[2:]
+        else:
+            break
+    if len(args) < 2 or not args[0].endswith('.psu'):
+        print(__doc__.strip().split('\n\n')[1], file=sys.stderr)
+        sys.exit(1)
+    name = os.path.basename(args[0])[:-4]
+    inputs, outputs = load_psu(args[0])
+    sys.stdout.write(generate(name, inputs, outputs, load_dtc(args[1:]), samples, batch))
+
+
+if __name__ == '__main__':
+    main()
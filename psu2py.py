@@ -65,7 +65,7 @@ def parse_psu(lines):
         elif cmd == 'D':
             # Depth: D,n
             depth = int(fields[1])
-        elif cmd in ('L', 'J', 'T', 'R'):
+        elif cmd in ('L', 'J', 'T', 'R', 'S', 'C'):
             body.append((cmd, fields[1:]))
 
     return inputs, outputs, depth, body
@@ -99,8 +99,105 @@ def generate_python(name, inputs, outputs, depth, body):
             lines.append(f'  {py_val} = auto()')
         lines.append('')
 
+    # The code is nested if/else, a label reached from more than one place
+    # (or one nested too deep) is a function of the inputs and the outputs
+    # so far, called where it is reached, so a call runs only its path
+    in_params = [to_py_ident(var) for var in inputs.keys()]
+    out_params = [f'_{to_py_ident(var)}' for var in outputs.keys()]
+    params = ', '.join(in_params + out_params)
+    output_tuple = ', '.join(out_params)
+    at = {}
+    refs = {}
+    falls = True
+    for i, (cmd, args) in enumerate(body):
+        if cmd == 'L':
+            at[args[0]] = i
+            if falls:
+                refs[args[0]] = refs.get(args[0], 0) + 1
+        elif cmd in ('T', 'C'):
+            refs[args[2]] = refs.get(args[2], 0) + 1
+        elif cmd == 'J':
+            refs[args[0]] = refs.get(args[0], 0) + 1
+        falls = cmd != 'J'
+    funcs = {label for label, n in refs.items() if n > 1 and label != '0'}
+    # Switch targets are dispatched by a dict of functions, one per S
+    cases = {}
+    for i, (cmd, args) in enumerate(body):
+        if cmd == 'S':
+            cases[i] = []
+            for ccmd, cargs in body[i + 1:]:
+                if ccmd != 'C':
+                    break
+                cases[i].append((to_py_ident(cargs[1]), cargs[2]))
+                funcs.add(cargs[2])
+
+    def call(label):
+        return f'_n{label}({params})'
+
+    def block(i, indent, out, queue):
+        """Code from body line i, nested in indent, until it returns."""
+        start = i
+        while i < len(body):
+            cmd, args = body[i]
+            if cmd == 'L':
+                if args[0] == '0':
+                    break
+                if args[0] in funcs and i != start:
+                    out.append(f'{indent}return {call(args[0])}')
+                    queue.append(args[0])
+                    return
+            elif cmd == 'T':
+                py_var = to_py_ident(args[0])
+                out.append(f'{indent}if {py_var} == {py_var}.{to_py_ident(args[1])}:')
+                target(args[2], indent + '  ', out, queue)
+            elif cmd == 'S':
+                py_var = to_py_ident(args[0])
+                out.append(f'{indent}_f = {switches[i]}.get({py_var})')
+                out.append(f'{indent}if _f is not None:')
+                out.append(f'{indent}  return _f({params})')
+                queue.extend(label for val, label in cases[i])
+            elif cmd == 'J':
+                target(args[0], indent, out, queue)
+                return
+            elif cmd == 'R':
+                py_var = to_py_ident(args[0])
+                out.append(f'{indent}_{py_var} = {py_var}.{to_py_ident(args[1])}')
+            i += 1
+        out.append(f'{indent}return ({output_tuple})')
+
+    def target(label, indent, out, queue):
+        # Python allows 100 levels of indentation, deeper ones are functions
+        if label != '0' and label not in funcs and len(indent) > 80:
+            funcs.add(label)
+        if label == '0':
+            out.append(f'{indent}return ({output_tuple})')
+        elif label in funcs:
+            out.append(f'{indent}return {call(label)}')
+            queue.append(label)
+        else:
+            block(at[label], indent, out, queue)
+
+    # The switch tables and functions before evaluate, in the order reached
+    switches = {i: f'_S{n + 1}' for n, i in enumerate(cases)}
+    main = []
+    queue = []
+    block(0, '  ', main, queue)
+    done = set()
+    for label in queue:
+        if label in done:
+            continue
+        done.add(label)
+        lines.append(f'def _n{label}({params}):')
+        block(at[label] if label != '0' else len(body), '  ', lines, queue)
+        lines.append('')
+    for i, name in switches.items():
+        items = ', '.join(f'{to_py_ident(body[i][1][0])}.{val}: _n{label}' for val, label in cases[i])
+        lines.append(f'{name} = {{{items}}}')
+    if switches:
+        lines.append('')
+
     # Function signature
-    input_params = ', '.join(to_py_ident(var) for var in inputs.keys())
+    input_params = ', '.join(in_params)
     lines.append(f'def evaluate({input_params}):')
     if depth:
         lines.append(f'  """Evaluate decision table (max depth: {depth})"""')
@@ -109,69 +206,7 @@ def generate_python(name, inputs, outputs, depth, body):
     for var in outputs.keys():
         py_var = to_py_ident(var)
         lines.append(f'  _{py_var} = None')
-
-    # State machine
-    lines.append('  _s = 0')
-    lines.append('  while True:')
-
-    # Process body - need to look ahead for fallthrough
-    current_state = 0
-    need_state = True
-    indent = '      '
-
-    for i, (cmd, args) in enumerate(body):
-        # Look ahead to find next label for fallthrough
-        next_label = None
-        for j in range(i + 1, len(body)):
-            if body[j][0] == 'L':
-                lbl = body[j][1][0]
-                if lbl != '0':
-                    next_label = lbl
-                break
-
-        if cmd == 'L':
-            # Label: L,n
-            label = args[0]
-            if label != '0':
-                current_state = int(label)
-                need_state = True
-        elif cmd == 'T':
-            # Test: T,var,val,target
-            var, val, target = args[0], args[1], args[2]
-            py_var = to_py_ident(var)
-            py_val = to_py_ident(val)
-            if need_state:
-                lines.append(f'    if _s == {current_state}:')
-                need_state = False
-            lines.append(f'{indent}if {py_var} == {py_var}.{py_val}:')
-            lines.append(f'{indent}  _s = {target}')
-            lines.append(f'{indent}  continue')
-            # Add fallthrough to next label
-            if next_label:
-                lines.append(f'{indent}_s = {next_label}')
-                lines.append(f'{indent}continue')
-        elif cmd == 'J':
-            # Jump: J,target
-            target = args[0]
-            if need_state:
-                lines.append(f'    if _s == {current_state}:')
-                need_state = False
-            if target == '0':
-                # Return
-                output_tuple = ', '.join(f'_{to_py_ident(var)}' for var in outputs.keys())
-                lines.append(f'{indent}return ({output_tuple})')
-            else:
-                lines.append(f'{indent}_s = {target}')
-                lines.append(f'{indent}continue')
-        elif cmd == 'R':
-            # Resolve: R,var,val
-            var, val = args[0], args[1]
-            py_var = to_py_ident(var)
-            py_val = to_py_ident(val)
-            if need_state:
-                lines.append(f'    if _s == {current_state}:')
-                need_state = False
-            lines.append(f'{indent}_{py_var} = {py_var}.{py_val}')
+    lines.extend(main)
 
     lines.append('')
     return '\n'.join(lines)